@@ -36,6 +36,16 @@ def main():
     parser.add_argument(
         "--static", action="store_true", help="Link libraries statically"
     )
+    parser.add_argument(
+        "--stats",
+        action="store_true",
+        help="Collect allocator statistics (PALLOC_STATS)",
+    )
+    parser.add_argument(
+        "--heap-profile",
+        action="store_true",
+        help="Compile in the sampling heap profiler (PALLOC_PROFILING)",
+    )
     parser.add_argument(
         "--install",
         help="Install to the specified prefix (e.g., ~/.local or /usr/local)",
@@ -96,6 +106,8 @@ def main():
         f"-DPALLOC_BUILD_TESTS={'ON' if build_tests else 'OFF'}",
         f"-DPALLOC_BUILD_STRESS_TESTS={'ON' if args.stress_test else 'OFF'}",
         f"-DPALLOC_STATIC_LINKING={'ON' if args.static else 'OFF'}",
+        f"-DPALLOC_ENABLE_STATS={'ON' if args.stats else 'OFF'}",
+        f"-DPALLOC_ENABLE_PROFILING={'ON' if args.heap_profile else 'OFF'}",
     ]
 
     if args.asan:
@@ -3,6 +3,7 @@
 #include "arena.h"
 #include "dynamic_slab.h"
 #include "pool.h"
+#include "request_heap.h"
 #include <cstddef>
 
 namespace AL
@@ -32,7 +33,7 @@ struct arena_allocator
     {
         if (n == 0)
             return nullptr;
-        void* ptr = m_arena->alloc(n * sizeof(T));
+        void* ptr = m_arena->alloc(n * sizeof(T), alignof(T));
         if (!ptr)
             throw std::bad_alloc();
         return static_cast<pointer>(ptr);
@@ -107,6 +108,58 @@ struct slab_allocator
     }
 };
 
+template<typename T>
+struct request_heap_allocator
+{
+    using value_type = T;
+    using pointer = T*;
+    using const_pointer = const T*;
+    using reference = T&;
+    using const_reference = const T&;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+
+    request_heap* m_heap;
+
+    request_heap_allocator(request_heap* h) noexcept : m_heap(h)
+    {}
+
+    template<typename U>
+    request_heap_allocator(const request_heap_allocator<U>& other) noexcept : m_heap(other.m_heap)
+    {}
+
+    [[nodiscard]] pointer allocate(size_type n)
+    {
+        if (n == 0)
+            return nullptr;
+        if (n > static_cast<size_type>(-1) / sizeof(T))
+            throw std::bad_alloc();
+        void* ptr = m_heap->alloc(n * sizeof(T), alignof(T));
+        if (!ptr)
+            throw std::bad_alloc();
+        return static_cast<pointer>(ptr);
+    }
+
+    void deallocate(pointer p, size_type n) noexcept
+    {
+        // recycled within the request, everything else goes at the heap's reset()
+        if (p && n > 0)
+            m_heap->free(p, n * sizeof(T), alignof(T));
+    }
+
+    template<typename U>
+    bool operator==(const request_heap_allocator<U>& other) const noexcept
+    {
+        return m_heap == other.m_heap;
+    }
+
+    template<typename U>
+    bool operator!=(const request_heap_allocator<U>& other) const noexcept
+    {
+        return m_heap != other.m_heap;
+    }
+};
+
 template<typename T>
 struct pool_allocator
 {
@@ -1,7 +1,13 @@
 #pragma once
 
+#include "stats.h"
+#include <array>
 #include <atomic>
 #include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
 
 namespace AL
 {
@@ -16,34 +22,296 @@ public:
     arena& operator=(arena&&) noexcept;
 
     // allocates a block of memory of specified length from the arena
-    // returns properly aligned memory
+    // alignment must be a power of two. the default fits any type, smaller alignments waste less padding
+    // and larger ones (cache line, page) are honoured too
     // returns: nullptr if failed, else the memory address of the block of memory
-    [[nodiscard]] void* alloc(size_t length);
+    [[nodiscard]] void* alloc(size_t length, size_t alignment = default_alignment);
 
     // allocates a block of memory of specified length from the arena
     // also zeroes out the memory returned
-    // returns properly aligned memory
     // returns: nullptr if failed, else the memory address of the block of memory
-    [[nodiscard]] void* calloc(size_t length);
+    [[nodiscard]] void* calloc(size_t length, size_t alignment = default_alignment);
 
-    // frees the entire arena but keeps it alive to reuse
+    static constexpr size_t default_alignment = alignof(std::max_align_t);
+
+    // resizes the block at ptr from old_len to new_len bytes without moving it. only the most recent
+    // allocation can grow: its end has to be the bump offset or, with thread chunks, the calling thread's
+    // chunk cursor, and a chunk allocation only grows inside its chunk. the offset is moved with a CAS,
+    // so it is safe against concurrent alloc(). shrinking always succeeds, and hands the tail back
+    // when ptr is the most recent allocation
+    // returns: true if ptr now holds new_len bytes
+    [[nodiscard]] bool try_extend(void* ptr, size_t old_len, size_t new_len);
+
+    // resizes in place with try_extend(), else allocates a new block and copies min(old_len, new_len)
+    // bytes. the old block stays used until reset(). a nullptr ptr just allocates
+    // returns: nullptr if failed or new_len is 0, and ptr is left as it was. else the resized block
+    [[nodiscard]] void* realloc(void* ptr, size_t old_len, size_t new_len, size_t alignment = default_alignment);
+
+    // constructs a T in the arena. a T that is not trivially destructible also gets a destructor record
+    // in the arena, in front of the object, so reset(), clear(), rollback() past it and ~arena() run its
+    // destructor, newest first. trivially destructible types cost nothing beyond alloc()
+    // thread safe. an exception from T's constructor propagates and the bytes stay used until reset()
+    // returns: nullptr if the arena is full
+    template<typename T, typename... Args>
+    [[nodiscard]] T* make(Args&&... args)
+    {
+        void* ptr = alloc_object(sizeof(T), alignof(T), std::is_trivially_destructible_v<T> ? nullptr : &destroy_objects<T>, 1);
+        if (ptr == nullptr)
+            return nullptr;
+
+        T* obj = ::new (ptr) T(std::forward<Args>(args)...);
+        if constexpr (!std::is_trivially_destructible_v<T>)
+            commit_object(ptr, alignof(T));
+        return obj;
+    }
+
+    // constructs n value-initialized Ts in the arena, destroyed together like make()
+    // if an element's constructor throws, the ones before it are destroyed and the exception propagates
+    // returns: nullptr if the arena is full or n is 0
+    template<typename T>
+    [[nodiscard]] T* make_array(size_t n)
+    {
+        if (n == 0 || n > static_cast<size_t>(-1) / sizeof(T))
+            return nullptr;
+
+        void* ptr = alloc_object(n * sizeof(T), alignof(T), std::is_trivially_destructible_v<T> ? nullptr : &destroy_objects<T>, n);
+        if (ptr == nullptr)
+            return nullptr;
+
+        T* first = static_cast<T*>(ptr);
+        size_t constructed = 0;
+        try
+        {
+            for (; constructed < n; ++constructed)
+                ::new (static_cast<void*>(first + constructed)) T();
+        }
+        catch (...)
+        {
+            destroy_objects<T>(first, constructed);
+            throw;
+        }
+        if constexpr (!std::is_trivially_destructible_v<T>)
+            commit_object(ptr, alignof(T));
+        return first;
+    }
+
+    // allocates from the top end of the arena, growing down towards what alloc() hands out. both ends
+    // share one mapping and one capacity, so long-lived data can come from alloc() and temporaries from
+    // here, freed early with reset_top(). thread safe, also against alloc() on other threads
+    // returns: nullptr if the two ends would meet, else the memory address of the block of memory
+    [[nodiscard]] void* alloc_top(size_t length, size_t alignment = default_alignment);
+
+    // same as alloc_top, also zeroes out the memory returned
+    [[nodiscard]] void* calloc_top(size_t length, size_t alignment = default_alignment);
+
+    // frees everything allocated from the top end, leaving the bottom as it is. pages the top end
+    // touched stay resident until reset() applies the retention limits below
+    // NOT thread safe
+    void reset_top();
+
+    // bytes allocated from the top end, including alignment padding
+    size_t get_used_top() const;
+
+    // 0 (the default) bumps the shared offset with a CAS on every alloc, so concurrent threads contend on it.
+    // otherwise each thread reserves `bytes` at a time from the shared offset and bump allocates inside
+    // its chunk without atomics. get_used() then counts whole chunks, and the unused tail of a thread's
+    // chunk is lost until reset(). an allocation larger than a chunk goes straight to the shared offset.
+    // NOT thread safe, set it before other threads allocate
+    void set_thread_chunk_size(size_t bytes);
+
+    // frees the entire arena, both ends, but keeps it alive to reuse. objects from make() are destroyed
+    // first, and every thread's chunk is retired.
+    // pages above the retention limits below are returned to the OS, they stay mapped
     // NOT thread safe
     // returns: -1 if failed
     int reset();
 
+    // reset() keeps at most `bytes` of touched pages resident. SIZE_MAX (the default) keeps them all
+    void set_retained_bytes(size_t bytes);
+
+    // reset() keeps pages up to a high-water mark resident: the peak use of the cycle that just ended,
+    // or the previous mark shrunk by `percent`, whichever is larger. so one outlier cycle is forgotten
+    // over a few resets instead of pinning its pages. 0 (the default) turns it off.
+    // set_retained_bytes() still caps the result
+    void set_high_water_decay(unsigned percent);
+
+    // bytes of the mapping that are resident right now (mincore). every byte on windows
+    size_t get_resident() const;
+
+    static constexpr size_t max_size_window = 64;
+
+    // makes reset() resize the arena to the `percentile` of the peak demand of the last `window` cycles
+    // (at most max_size_window). a cycle's demand is its peak offset plus the top end plus the bytes
+    // of every request that failed. growing past the mapping remaps it with mremap, which may move
+    // it; shrinking purges the pages above the new capacity and keeps them mapped for a later grow.
+    // so an arena constructed with a guess settles on one block that fits most cycles, and the rare
+    // larger cycle fails or spills instead of pinning memory. 0 (the default) keeps the capacity fixed.
+    // NOT thread safe, set it before other threads allocate
+    void set_auto_size(unsigned percentile, size_t window = max_size_window);
+
     // unmaps all memory
     // returns: -1 if failed
     int clear();
 
+    // a position of the bump offset to roll back to
+    struct marker
+    {
+        size_t offset = 0;
+    };
+
+    // thread safe
+    marker mark() const;
+
+    // frees every allocation made after m was taken, so nested phases can drop their scratch memory
+    // and keep what came before. objects from make() placed past m are destroyed. markers are rolled back innermost first, and one taken before the
+    // last reset() must not be used. every thread's chunk is retired; what threads allocated from
+    // chunks they reserved before m is kept but not reused until reset().
+    // NOT thread safe: no other thread may allocate while it runs, and allocations other threads
+    // made after m are freed along with the caller's
+    // returns: -1 if m lies past the current offset (an outer marker was already rolled back)
+    int rollback(marker m);
+
+    // rolls the arena back to where it was at construction when it goes out of scope.
+    // the same rules as rollback() apply
+    class scope
+    {
+    public:
+        explicit scope(arena& a) : owner(a), saved(a.mark())
+        {}
+
+        ~scope()
+        {
+            owner.rollback(saved);
+        }
+
+        scope(const scope&) = delete;
+        scope& operator=(const scope&) = delete;
+
+    private:
+        arena& owner;
+        marker saved;
+    };
+
     // gets the amount of bytes used by the arena
     size_t get_used() const;
 
     // gets the total amount of bytes that can be used by the arena
     size_t get_capacity() const;
 
+    // snapshot of the arena's counters. counters are zero unless built with PALLOC_STATS
+    arena_stats stats() const;
+
 private:
+    // destroys count objects starting at first, last one first
+    using destroy_fn = void (*)(void* first, size_t count);
+
+    template<typename T>
+    static void destroy_objects(void* first, size_t count)
+    {
+        T* objects = static_cast<T*>(first);
+        while (count != 0)
+            objects[--count].~T();
+    }
+
+    // destructor record, allocated right in front of the objects it destroys
+    struct destructor_node
+    {
+        destructor_node* next;
+        destroy_fn destroy;
+        void* objects;
+        size_t count;
+
+        // distance from the node to objects aligned to alignment
+        static size_t object_offset(size_t alignment)
+        {
+            return (sizeof(destructor_node) + alignment - 1) & ~(alignment - 1);
+        }
+    };
+
+    // allocates room for the objects, plus a destructor_node in front of them when destroy is set.
+    // the node is filled in but not linked until commit_object(), so a throwing constructor leaves no record
+    void* alloc_object(size_t bytes, size_t alignment, destroy_fn destroy, size_t count);
+    // links the node in front of ptr, once its objects are constructed
+    void commit_object(void* ptr, size_t alignment);
+    // runs and unlinks every destructor recorded at or above boundary, newest first
+    void run_destructors(const std::byte* boundary);
+
+    // bump allocates length bytes from the shared offset with a CAS
+    void* alloc_shared(size_t length, size_t alignment);
+    // bump allocates from the calling thread's chunk, reserving a new one when it is exhausted
+    void* alloc_chunked(size_t length, size_t alignment, size_t chunk_bytes);
+
+    // a thread's current chunk of one arena. only valid while generation matches the arena's,
+    // so chunks of a reset arena, or of a destroyed one whose address was reused, are never bumped
+    struct thread_chunk
+    {
+        const arena* owner = nullptr;
+        uint64_t generation = 0;
+        std::byte* cursor = nullptr;
+        std::byte* end = nullptr;
+    };
+
+    static constexpr size_t max_thread_chunks = 4;
+    thread_local static std::array<thread_chunk, max_thread_chunks> chunks;
+
+    // the calling thread's chunk slot for this arena. it may still hold another arena's chunk
+    thread_chunk& local_chunk()
+    {
+        // direct mapped by address, a collision just retires the other arena's chunk
+        return chunks[(reinterpret_cast<uintptr_t>(this) / alignof(arena)) % max_thread_chunks];
+    }
+
+    // unique across every arena, so a reused address never matches an old chunk
+    static std::atomic<uint64_t> next_generation;
+    std::atomic<uint64_t> generation;
+    std::atomic<size_t> chunk_size;
+
+    // newest first. pushed with a CAS, so make() stays thread safe
+    std::atomic<destructor_node*> destructors{nullptr};
+
     std::byte* memory;
     std::atomic<size_t> used;
+    // lowest offset handed out by alloc_top(), capacity when the top end is empty.
+    // each end bumps its own offset and then checks the other's, see alloc_shared()
+    std::atomic<size_t> top;
     size_t capacity;
+
+    stat_counter stat_failed;
+    stat_counter stat_resets;
+    stat_counter stat_chunk_refills;
+    stat_counter stat_rollbacks;
+    stat_counter stat_purged_bytes;
+    stat_counter stat_extends;
+    stat_counter stat_resizes;
+
+    // purges touched pages above what the retention limits keep. peak is the cycle's highest offset
+    int release_above(size_t peak);
+
+    // records a failed request for set_auto_size(), and counts it
+    void note_failed(size_t length);
+    // adds the cycle's demand to the history and resizes to the chosen percentile of it
+    int resize_to_demand(size_t demand);
+
+    // peak demand of recent cycles for set_auto_size(), a ring of window entries. only touched by reset()
+    struct size_history
+    {
+        std::array<size_t, max_size_window> peaks{};
+        size_t count = 0;
+        size_t next = 0;
+        size_t window = 0;
+        unsigned percentile = 0;
+    };
+    size_history sizing;
+    // bytes of the requests that failed this cycle
+    std::atomic<size_t> failed_bytes{0};
+    // bytes mapped at memory. capacity may be less after set_auto_size() shrank the arena
+    size_t mapped = 0;
+
+    // retention state, only touched by reset(), reset_top() and rollback()
+    size_t retained_bytes = static_cast<size_t>(-1);
+    unsigned decay_percent = 0;
+    size_t high_water = 0;
+    size_t cycle_peak = 0; // highest offset a rollback() rewound from this cycle
+    size_t touched = 0;    // offset below which pages may be resident, capacity once the top end was used
 };
 } // namespace AL
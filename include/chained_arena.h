@@ -0,0 +1,119 @@
+#pragma once
+
+#include "stats.h"
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+
+namespace AL
+{
+// how chained_arena sizes the blocks it links once the current one is full
+struct chained_arena_growth
+{
+    // each new block is the previous block's size times factor. 1 keeps every block the same size
+    size_t factor = 2;
+    // blocks stop growing at this size. a larger allocation still gets a block that fits it, see alloc()
+    size_t max_block_bytes = 64 * 1024 * 1024;
+};
+
+//
+// an arena that never runs out: when the current block is full it maps a larger one and links it in
+// front of the others. allocation is the same single CAS on the current block's offset as arena::alloc,
+// only a full block takes the grow lock.
+//
+class chained_arena
+{
+public:
+    // bytes is the first block's size, rounded up to a page boundary
+    explicit chained_arena(size_t bytes, const chained_arena_growth& growth = {});
+    ~chained_arena();
+
+    chained_arena(const chained_arena&) = delete;
+    chained_arena& operator=(const chained_arena&) = delete;
+    chained_arena(chained_arena&&) = delete;
+    chained_arena& operator=(chained_arena&&) = delete;
+
+    // allocates a block of memory of specified length, linking a new block if the current one is full.
+    // a length beyond the next scheduled block gets a block of its own, set aside so the current
+    // block keeps filling and the schedule does not grow
+    // alignment must be a power of two, see arena::alloc()
+    // returns: nullptr if failed, else the memory address of the block of memory
+    [[nodiscard]] void* alloc(size_t length, size_t alignment = default_alignment);
+
+    // same as alloc, also zeroes out the memory returned
+    [[nodiscard]] void* calloc(size_t length, size_t alignment = default_alignment);
+
+    static constexpr size_t default_alignment = alignof(std::max_align_t);
+
+    // frees every allocation. keeps the largest scheduled block for reuse and unmaps the rest,
+    // so the next cycle starts with the capacity the last one grew to. blocks of oversized allocations
+    // are always unmapped
+    // NOT thread safe
+    // returns: -1 if failed
+    int reset();
+
+    // unmaps every block. the next allocation maps a new first block of the constructor's size
+    // NOT thread safe
+    // returns: -1 if failed
+    int clear();
+
+    // bytes handed out from every block, including alignment padding
+    size_t get_used() const;
+
+    // usable bytes of every block
+    size_t get_capacity() const;
+
+    size_t get_block_count() const;
+
+    // snapshot of the arena's counters. counters are zero unless built with PALLOC_STATS
+    chained_arena_stats stats() const;
+
+private:
+    // header at the start of every mapping. allocations start at data()
+    struct block
+    {
+        block* prev;
+        size_t mapped;   // bytes mapped, header included
+        size_t capacity; // bytes after the header
+        std::atomic<size_t> used;
+
+        std::byte* data()
+        {
+            return reinterpret_cast<std::byte*>(this) + header_size();
+        }
+    };
+
+    static constexpr size_t header_size()
+    {
+        return (sizeof(block) + default_alignment - 1) & ~(default_alignment - 1);
+    }
+
+    // maps a block with at least bytes of usable space. returns nullptr if the mapping failed
+    static block* map_block(size_t bytes, block* prev);
+    static bool unmap_block(block* b);
+    // unmaps b and every block before it. returns: false if any munmap failed
+    static bool unmap_chain(block* b);
+
+    // bumps b's offset with a CAS. returns: nullptr if length does not fit
+    static void* try_alloc(block& b, size_t length, size_t alignment);
+
+    // takes grow_mutex and links a new block unless another thread already did
+    void* alloc_slow(size_t length, size_t alignment);
+
+    std::atomic<block*> current;
+    // blocks mapped for a single oversized allocation, linked through prev. only pushed under grow_mutex
+    std::atomic<block*> oversized;
+    std::atomic<size_t> block_count;
+
+    // size of the next block, advanced by the growth factor. guarded by grow_mutex
+    size_t next_block_bytes;
+    const size_t first_block_bytes;
+    const size_t growth_factor;
+    const size_t max_block_bytes;
+    std::mutex grow_mutex;
+
+    stat_counter stat_failed;
+    stat_counter stat_grows;
+    stat_counter stat_resets;
+};
+} // namespace AL
@@ -1,21 +1,40 @@
 #pragma once
 
+#include "page_map.h"
 #include "slab.h"
+#include "stats.h"
+#include <array>
 #include <atomic>
+#include <chrono>
 #include <cstddef>
+#include <cstdint>
 #include <mutex>
+#include <new>
 
 namespace AL
 {
+// how dynamic_slab sizes the slab nodes it maps. the defaults give every node the constructor's scale
+struct dynamic_slab_growth
+{
+    // each new node's scale is the previous node's scale times factor. 1 keeps every node the same size
+    size_t factor = 1;
+    // nodes stop growing once they reach this scale (or the constructor's scale, if that is larger)
+    size_t max_scale = 64;
+    // nodes mapped by the constructor, sized by the same schedule. at least one node is always mapped.
+    // trim() retains at least this many empty nodes, see set_retained_empty_nodes()
+    size_t reserve_nodes = 1;
+};
+
 class dynamic_slab
 {
 public:
-    explicit dynamic_slab(size_t scale = 1.0);
+    // scale is the first node's scale, see slab::slab()
+    explicit dynamic_slab(size_t scale = 1.0, const dynamic_slab_growth& growth = {});
 
-    // WARNING: this destructor only cleans up the current thread's thread local caches (TLC).
-    // if other threads have allocated from this dynamic_slab, their TLC
-    // will still hold pointers to slabs managed by this object.
-    // ensure all other threads have ceased operations or cleared their caches before destroying this object
+    // nodes that become empty are released back to the OS, see trim().
+    //
+    // every thread's thread local cache (TLC) entry for this dynamic_slab is detached, like slab::~slab().
+    // other threads may keep running, as long as none of them still uses this dynamic_slab
     ~dynamic_slab();
 
     dynamic_slab(const dynamic_slab&) = delete;
@@ -31,30 +50,233 @@ public:
     // returns memory is properly aligned
     [[nodiscard]] void* calloc(size_t size);
 
-    // free pointer allocated by this dynamic_slab
+    // free pointer allocated by this dynamic_slab. pointers it did not allocate are ignored
     void free(void* ptr, size_t size);
 
     size_t get_total_capacity() const;
     size_t get_total_free() const;
     size_t get_slab_count() const;
 
+    // unlinks every slab node that has no live blocks, keeping `retained_empty_nodes` of them mapped,
+    // and unmaps retired nodes that no thread can still be reading.
+    // blocks the calling thread caches are flushed first, other threads' caches keep their nodes alive.
+    // the same pass runs automatically every `trim_interval` frees per thread, but then only retires
+    // nodes that have been empty for the release delay, so a workload that shrinks and grows
+    // again does not unmap and remap nodes back to back.
+    // thread-safe
+    // returns: number of nodes unlinked by this call
+    size_t trim();
+
+    // empty nodes that stay mapped to absorb the next burst. default 1, or growth.reserve_nodes if larger
+    void set_retained_empty_nodes(size_t count);
+
+    // how long a node must stay empty before an automatic pass releases it. default 1 second
+    void set_release_delay(std::chrono::milliseconds delay);
+
+    // spreads threads over `count` home nodes (at most max_home_nodes), assigned round robin by thread.
+    // a thread allocates from its home node first and only spills to other nodes while a size class
+    // there is exhausted, so threads stop piling onto the same node's pools. free() is unaffected.
+    // 0 (the default) lets every thread start from the newest node
+    void set_home_nodes(size_t count);
+
+    static constexpr size_t max_home_nodes = 64;
+
+    // caps on the bytes this dynamic_slab maps for its nodes, 0 for no limit.
+    // before a grow would take it past soft_bytes, palloc() flushes the calling thread's cache and
+    // releases every empty node beyond the retained ones, like trim(), and only grows if that freed nothing usable.
+    // a grow that would pass hard_bytes fails and palloc() returns nullptr.
+    // nodes that are already mapped are never released to meet a new limit
+    void set_memory_limits(size_t soft_bytes, size_t hard_bytes);
+
+    // bytes currently mapped for slab nodes, including retired nodes that are not unmapped yet
+    size_t get_mapped_bytes() const;
+
+    // snapshot summed over every slab node. TLC counters and cached bytes come from this dynamic_slab's own
+    // thread caches. counters are zero unless built with PALLOC_STATS
+    dynamic_slab_stats stats() const;
+
 private:
+    // frees between two automatic trim passes, per thread
+    static constexpr size_t trim_interval = 4096;
+
+    static constexpr size_t NUM_SIZE_CLASSES = slab::size_class_count();
+
+    // listed nodes palloc tries without a lock before it falls back to the grow path
+    static constexpr size_t max_listed_attempts = 8;
+
     struct slab_node
     {
         slab value;
-        slab_node* next;
+        // atomic because trim() unlinks nodes while other threads traverse the list
+        std::atomic<slab_node*> next;
+
+        // per size class stack of nodes that may have free blocks, see available_list.
+        // avail_next is guarded by that class's mutex, listed may be read without it
+        std::array<slab_node*, NUM_SIZE_CLASSES> avail_next{};
+        std::array<std::atomic<bool>, NUM_SIZE_CLASSES> listed{};
+
+        // false while the node is retired, so a late free cannot put it back on an available list.
+        // written under grow_mutex, read under the class mutexes
+        std::atomic<bool> linked{false};
+
+        // only accessed under grow_mutex
+        bool seen_empty = false;
+        std::chrono::steady_clock::time_point empty_since;
+        uint64_t retire_epoch = 0;
+        slab_node* retired_next = nullptr;
 
         slab_node(size_t scale, slab_node* next_ptr) : value(scale), next(next_ptr)
         {}
     };
 
-    // allocate and construct a new slab_node via mmap
+    // allocate and construct a new slab_node via mmap and register its pool pages in owners.
+    // the node gets next_scale, which then advances by the growth factor.
+    // must hold grow_mutex (or be in the constructor)
     slab_node* create_node(slab_node* next_ptr);
+    void destroy_node(slab_node* node);
+
+    // bytes a node maps, header included, or would map if created with the given scale
+    static size_t node_bytes(const slab_node& node);
+    static size_t node_bytes(size_t scale);
+    // true if mapping the next node would take mapped_bytes past limit (0 is no limit). must hold grow_mutex
+    bool next_node_exceeds(const std::atomic<size_t>& limit) const;
+
+    // returns a retired node that is still mapped to the list, or creates a new one unless that
+    // would pass the hard limit. must hold grow_mutex
+    slab_node* grow_locked();
+
+    // prepends node to the list and to every available list. must hold grow_mutex
+    void publish_locked(slab_node* node);
+
+    // nodes a size class can currently allocate from. a node is pushed when it is added or a free
+    // finds it unlisted, and popped once an allocation from it fails while it is on top,
+    // so a full node is tried at most once per listing. pushes and pops take the mutex, palloc reads head without it
+    struct alignas(std::hardware_destructive_interference_size) available_list
+    {
+        std::mutex mutex;
+        std::atomic<slab_node*> head{nullptr};
+    };
+
+    void list_available(slab_node* node, size_t index);
+    void unlist_if_top(slab_node* node, size_t index);
+    // removes node from every available list wherever it sits. must hold grow_mutex
+    void unlist_all_locked(slab_node* node);
+
+    // last node this thread refilled a size class from. only valid while version still matches,
+    // so a node that trim() unlinked is never used through a stale hint
+    struct node_hint
+    {
+        uint64_t version = 0;
+        slab_node* node = nullptr;
+    };
+
+    //
+    // one thread local cache per size class for the whole dynamic_slab. it is refilled in batches from
+    // whichever node has room and flushed back to the owning nodes, so the hit rate does not depend on
+    // how many nodes there are. the nodes' own slab caches are never used.
+    // each thread keeps entries for up to max_cached_instances dynamic_slabs, registered with their
+    // owner the same way slab registers its entries (see slab.h)
+    //
+    static constexpr size_t max_cached_instances = 4;
+
+    struct thread_registration;
+
+    struct cache_entry
+    {
+        // atomic so ~dynamic_slab can hand the slot back from another thread
+        std::atomic<dynamic_slab*> owner;
+        std::array<thread_local_cache, NUM_SIZE_CLASSES> storage;
+        std::array<node_hint, NUM_SIZE_CLASSES> hints;
+
+        // links in the owner's registry, and the thread this entry belongs to.
+        // written under the owner's registry_mutex
+        cache_entry* registry_prev = nullptr;
+        cache_entry* registry_next = nullptr;
+        thread_registration* thread = nullptr;
+    };
+
+    thread_local static std::array<cache_entry, max_cached_instances> caches;
+
+    // the calling thread's entry for this dynamic_slab, claiming or evicting a slot on first use
+    cache_entry& get_cache();
+
+    // links entry into this dynamic_slab's registry and makes it the owner
+    void attach(cache_entry& entry, thread_registration& thread);
+    // flushes entry back to the nodes, unlinks it and clears its owner. must hold the entry's thread lock
+    void detach(cache_entry& entry);
+    // returns every block entry caches to its owning node. only the entry's thread may call it
+    void flush_entry(cache_entry& entry);
+
+    // takes up to count blocks of size class index from a node with room, growing the list if none has any.
+    // returns: number of blocks written to out
+    size_t refill(cache_entry& entry, size_t index, size_t count, void** out);
+    // returns count cached blocks of size class index to their owning nodes
+    void flush(size_t index, size_t count, void** blocks);
+
+    static thread_registration& register_thread();
+
+    // returns the calling thread's home node slot, or max_home_nodes if home nodes are off
+    size_t home_slot() const;
+    // gives slot a node no other home slot uses, growing the list if there is none. takes grow_mutex
+    void assign_home(size_t slot);
+
+    // must hold grow_mutex. `automatic` applies the release delay
+    size_t trim_locked(bool automatic);
+    void reclaim_retired_locked();
+
+    // counts frees on this thread and runs an automatic trim pass every trim_interval
+    void maybe_trim();
+
+    // scale of the next node create_node() maps, capped at max_scale. guarded by grow_mutex
+    size_t next_scale;
+    const size_t growth_factor;
+    const size_t max_scale;
 
-    size_t scale;
     std::atomic<slab_node*> head;
     std::atomic<size_t> node_count;
     std::mutex grow_mutex; // only held when adding a new slab
+
+    // page -> slab_node of every pool page, so free() finds the owning node in O(1).
+    // written under grow_mutex before the node is published, read lock free
+    page_map owners;
+
+    std::array<available_list, NUM_SIZE_CLASSES> available;
+
+    // bumped whenever trim() unlinks a node, invalidating every thread's hints
+    std::atomic<uint64_t> list_version;
+
+    // home node of each slot, see set_home_nodes(). written under grow_mutex, read lock free under a guard
+    std::atomic<size_t> home_count;
+    std::array<std::atomic<slab_node*>, max_home_nodes> homes{};
+    // node_count + 1 when the slot's last assign_home() failed, 0 otherwise. refill() only retries once
+    // the count changed, so threads under memory pressure do not queue on grow_mutex for a home
+    std::array<std::atomic<size_t>, max_home_nodes> home_failed_at{};
+
+    // cache entries of every thread that caches blocks of this dynamic_slab.
+    // lock order: a thread's lock before registry_mutex. the other direction only try_locks
+    mutable std::mutex registry_mutex;
+    cache_entry* registered = nullptr;
+    // counters of thread caches that were evicted or whose thread exited
+    std::array<tlc_counters, NUM_SIZE_CLASSES> retired_counters;
+
+    // unlinked nodes waiting for every reader to leave before they are unmapped. guarded by grow_mutex
+    slab_node* retired;
+    std::atomic<size_t> retained_empty_nodes;
+    std::atomic<int64_t> release_delay_ms;
+
+    // see set_memory_limits(). mapped_bytes is only written under grow_mutex (or by the constructor and destructor),
+    // so the limit check on the grow path is two relaxed loads
+    std::atomic<size_t> mapped_bytes;
+    std::atomic<size_t> soft_limit;
+    std::atomic<size_t> hard_limit;
+
+    // only written while holding grow_mutex
+    stat_counter stat_grows;
+    stat_counter stat_grow_failures;
+    stat_counter stat_releases;
+    stat_counter stat_evictions;
+    stat_counter stat_soft_limit_hits;
+    stat_counter stat_hard_limit_failures;
 };
 
 } // namespace AL
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace AL
+{
+
+//
+// epoch based reclamation shared by every allocator that unlinks memory lock free readers may still hold.
+// readers pin the current epoch with a guard for the duration of a lock free traversal.
+// a writer unlinks an object, calls retire() to get its retire epoch, and may only unmap it
+// once is_safe(retire_epoch) returns true, i.e. once every reader that could have seen it has left.
+//
+// pinning is a store to a thread local slot, no shared cache line is written. where the system has a
+// process wide barrier (platform_fence) the reader side needs no fence instruction either.
+//
+class epoch_domain
+{
+    struct thread_slot
+    {
+        // epoch this thread is pinned at, 0 while it is outside every guard
+        std::atomic<uint64_t> pinned;
+        uint32_t depth;
+        bool registered;
+    };
+
+    // trivially constructible so access needs no TLS init check
+    static inline thread_local thread_slot slot{};
+    static inline std::atomic<uint64_t> global_epoch{1}; // starts at 1 so a pinned slot is never 0
+
+    // set by the first register_thread() when platform_fence works. is_safe() then issues the
+    // barrier on behalf of every reader
+    static inline std::atomic<bool> asymmetric{false};
+
+    // links the calling thread's slot into the registry scanned by is_safe()
+    static void register_thread();
+
+public:
+    // pins the calling thread for its lifetime. guards may nest
+    class guard
+    {
+    public:
+        guard()
+        {
+            thread_slot& s = slot;
+            if (s.depth++ != 0)
+                return;
+            if (!s.registered) [[unlikely]]
+                register_thread();
+
+            s.pinned.store(global_epoch.load(std::memory_order_relaxed), std::memory_order_relaxed);
+
+            // the pin must be visible before any shared pointer is read.
+            // pairs with the barrier in is_safe(): either the writer sees this pin, or this thread sees the unlink
+            if (asymmetric.load(std::memory_order_relaxed))
+                std::atomic_signal_fence(std::memory_order_seq_cst);
+            else
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+        }
+
+        ~guard()
+        {
+            thread_slot& s = slot;
+            if (--s.depth == 0)
+                s.pinned.store(0, std::memory_order_release);
+        }
+
+        guard(const guard&) = delete;
+        guard& operator=(const guard&) = delete;
+    };
+
+    // call after unlinking an object. returns the epoch to pass to is_safe()
+    static uint64_t retire();
+
+    // returns: true once no thread is still pinned at an epoch older than retire_epoch
+    static bool is_safe(uint64_t retire_epoch);
+};
+
+} // namespace AL
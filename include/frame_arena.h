@@ -0,0 +1,114 @@
+#pragma once
+
+#include "arena.h"
+#include "stats.h"
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+namespace AL
+{
+//
+// N arenas used in rotation, one per frame. memory allocated during a frame stays valid for that frame
+// and the N - 1 after it: next_frame() moves to the next arena and resets it, which frees the data of
+// the frame N frames back. allocation is arena::alloc() on the current arena, so the thread chunk fast
+// path applies, and turnover is one arena::reset()
+//
+template<size_t N>
+class frame_arena
+{
+    static_assert(N >= 1, "frame_arena needs at least one frame");
+
+public:
+    // bytes is the capacity of each frame's arena, rounded up to a page boundary. N arenas are mapped
+    explicit frame_arena(size_t bytes) : arenas(make_arenas(bytes, std::make_index_sequence<N>{}))
+    {}
+
+    frame_arena(const frame_arena&) = delete;
+    frame_arena& operator=(const frame_arena&) = delete;
+
+    // allocates from the current frame, see arena::alloc()
+    // returns: nullptr if failed, else the memory address of the block of memory
+    [[nodiscard]] void* alloc(size_t length, size_t alignment = arena::default_alignment)
+    {
+        return arenas[index].alloc(length, alignment);
+    }
+
+    // same as alloc, also zeroes out the memory returned
+    [[nodiscard]] void* calloc(size_t length, size_t alignment = arena::default_alignment)
+    {
+        return arenas[index].calloc(length, alignment);
+    }
+
+    // the current frame's arena, for make<T>(), try_extend() and the rest of arena's interface.
+    // only valid until the next next_frame()
+    arena& current()
+    {
+        return arenas[index];
+    }
+
+    // ends the current frame and starts the next one in the oldest arena, freeing what was allocated
+    // N frames ago. records the ending frame's usage for stats()
+    // NOT thread safe, see arena::reset()
+    // returns: -1 if failed
+    int next_frame()
+    {
+        const size_t used = arenas[index].get_used();
+        last_frame_used = used;
+        peak_frame_used = std::max(peak_frame_used, used);
+        ++frame;
+
+        index = index + 1 == N ? 0 : index + 1;
+        return arenas[index].reset();
+    }
+
+    // applies arena::set_thread_chunk_size() to every frame's arena
+    // NOT thread safe, set it before other threads allocate
+    void set_thread_chunk_size(size_t bytes)
+    {
+        for (arena& a : arenas)
+            a.set_thread_chunk_size(bytes);
+    }
+
+    // frames started since construction
+    uint64_t get_frame() const
+    {
+        return frame;
+    }
+
+    // capacity of one frame's arena
+    size_t get_capacity() const
+    {
+        return arenas[0].get_capacity();
+    }
+
+    // snapshot of the frame counters. failed_allocs is zero unless built with PALLOC_STATS
+    frame_arena_stats stats() const
+    {
+        frame_arena_stats s;
+        s.frame = frame;
+        s.used = arenas[index].get_used();
+        s.capacity = get_capacity();
+        s.last_frame_used = last_frame_used;
+        s.peak_frame_used = peak_frame_used;
+        for (const arena& a : arenas)
+            s.failed_allocs += a.stats().failed_allocs;
+        return s;
+    }
+
+private:
+    template<size_t... I>
+    static std::array<arena, N> make_arenas(size_t bytes, std::index_sequence<I...>)
+    {
+        return {((void)I, arena(bytes))...};
+    }
+
+    std::array<arena, N> arenas;
+    size_t index = 0;
+    uint64_t frame = 0;
+    size_t last_frame_used = 0;
+    size_t peak_frame_used = 0;
+};
+} // namespace AL
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "stats.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace AL
+{
+//
+// a bump arena whose reset() is thread safe. the mapping is split into two halves and generations
+// alternate between them. the generation and the offset share one atomic word, so reset() is a single
+// CAS that publishes the next generation at offset 0. an alloc() racing with it either lands in the old
+// generation or fails its CAS and retries in the new one, there is no barrier.
+// memory stays valid until the second reset() after it was allocated, when its half is reused
+//
+class generational_arena
+{
+public:
+    // bytes is the capacity of each generation, rounded up to a page boundary. twice that is mapped.
+    // throws std::bad_alloc if the rounded capacity does not fit the 40 bit offset, 1 TiB minus a page at most
+    explicit generational_arena(size_t bytes);
+    ~generational_arena();
+
+    generational_arena(const generational_arena&) = delete;
+    generational_arena& operator=(const generational_arena&) = delete;
+    generational_arena(generational_arena&&) = delete;
+    generational_arena& operator=(generational_arena&&) = delete;
+
+    // allocates a block of memory of specified length from the current generation
+    // alignment must be a power of two, see arena::alloc()
+    // returns: nullptr if failed, else the memory address of the block of memory
+    [[nodiscard]] void* alloc(size_t length, size_t alignment = default_alignment);
+
+    // same as alloc, also zeroes out the memory returned
+    [[nodiscard]] void* calloc(size_t length, size_t alignment = default_alignment);
+
+    static constexpr size_t default_alignment = alignof(std::max_align_t);
+
+    // starts the next generation in the other half. the generation before the current one is freed,
+    // the current one stays valid until the next reset()
+    // thread safe, also against alloc()
+    // returns: -1 if failed
+    int reset();
+
+    // the current generation, counted modulo 2^24
+    uint64_t get_generation() const;
+
+    // bytes used by the current generation
+    size_t get_used() const;
+
+    // capacity of one generation
+    size_t get_capacity() const;
+
+    // snapshot of the arena's counters. counters are zero unless built with PALLOC_STATS
+    generational_arena_stats stats() const;
+
+private:
+    // low bits of state hold the offset, the rest the generation
+    static constexpr unsigned offset_bits = 40;
+    static constexpr uint64_t offset_mask = (uint64_t(1) << offset_bits) - 1;
+
+    std::byte* memory;
+    size_t capacity;
+    std::atomic<uint64_t> state;
+
+    stat_counter stat_failed;
+    stat_counter stat_resets;
+    stat_counter stat_retries;
+};
+} // namespace AL
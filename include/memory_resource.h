@@ -0,0 +1,167 @@
+#pragma once
+
+#include "arena.h"
+#include "dynamic_slab.h"
+#include "platform.h"
+#include "pool.h"
+#include "slab.h"
+#include <algorithm>
+#include <cstddef>
+#include <memory_resource>
+#include <new>
+
+namespace AL
+{
+//
+// std::pmr::memory_resource adapters, so std::pmr containers can allocate from palloc without changing
+// their types. like the allocator adaptors, they do not own the allocator they point to.
+// the slab resources pass the size std::pmr hands to do_deallocate() straight to the sized free().
+// a block of a power-of-two size class is aligned to its size, so an alignment above the requested
+// size is met by allocating from the size class of the alignment
+//
+
+// deallocate is a no-op unless the block is the arena's most recent, then its bytes are handed back
+class arena_resource : public std::pmr::memory_resource
+{
+public:
+    explicit arena_resource(arena* a) noexcept : m_arena(a)
+    {}
+
+    arena* get_arena() const noexcept
+    {
+        return m_arena;
+    }
+
+private:
+    void* do_allocate(size_t bytes, size_t alignment) override
+    {
+        void* ptr = m_arena->alloc(std::max<size_t>(bytes, 1), alignment);
+        if (!ptr)
+            throw std::bad_alloc();
+        return ptr;
+    }
+
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override
+    {
+        (void)alignment;
+        // shrinking to nothing only succeeds in freeing memory for the most recent allocation
+        (void)m_arena->try_extend(p, std::max<size_t>(bytes, 1), 0);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+    {
+        return this == &other;
+    }
+
+    arena* m_arena;
+};
+
+// serves requests that fit the pool's block size and alignment, one block each. anything else throws
+class pool_resource : public std::pmr::memory_resource
+{
+public:
+    explicit pool_resource(pool* p) noexcept : m_pool(p)
+    {}
+
+    pool* get_pool() const noexcept
+    {
+        return m_pool;
+    }
+
+private:
+    void* do_allocate(size_t bytes, size_t alignment) override
+    {
+        // blocks sit at multiples of the block size from a page aligned start, so a block is aligned to
+        // the block size's lowest set bit, but never beyond a page
+        const size_t block_size = m_pool->get_block_size();
+        const size_t block_alignment = std::min(block_size & (0 - block_size), platform_mem::page_size());
+        if (bytes > block_size || alignment > block_alignment)
+            throw std::bad_alloc();
+
+        void* ptr = m_pool->alloc();
+        if (!ptr)
+            throw std::bad_alloc();
+        return ptr;
+    }
+
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override
+    {
+        (void)bytes;
+        (void)alignment;
+        m_pool->free(p);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+    {
+        return this == &other;
+    }
+
+    pool* m_pool;
+};
+
+class slab_resource : public std::pmr::memory_resource
+{
+public:
+    explicit slab_resource(slab* s) noexcept : m_slab(s)
+    {}
+
+    slab* get_slab() const noexcept
+    {
+        return m_slab;
+    }
+
+private:
+    void* do_allocate(size_t bytes, size_t alignment) override
+    {
+        void* ptr = m_slab->alloc(std::max(bytes, alignment));
+        if (!ptr)
+            throw std::bad_alloc();
+        return ptr;
+    }
+
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override
+    {
+        m_slab->free(p, std::max(bytes, alignment));
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+    {
+        return this == &other;
+    }
+
+    slab* m_slab;
+};
+
+class dynamic_slab_resource : public std::pmr::memory_resource
+{
+public:
+    explicit dynamic_slab_resource(dynamic_slab* s) noexcept : m_slab(s)
+    {}
+
+    dynamic_slab* get_slab() const noexcept
+    {
+        return m_slab;
+    }
+
+private:
+    void* do_allocate(size_t bytes, size_t alignment) override
+    {
+        void* ptr = m_slab->palloc(std::max(bytes, alignment));
+        if (!ptr)
+            throw std::bad_alloc();
+        return ptr;
+    }
+
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override
+    {
+        m_slab->free(p, std::max(bytes, alignment));
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+    {
+        return this == &other;
+    }
+
+    dynamic_slab* m_slab;
+};
+} // namespace AL
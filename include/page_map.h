@@ -0,0 +1,84 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace AL
+{
+
+//
+// two level radix tree mapping 4 KiB pages of the 48 bit address space to an owner pointer.
+// lookups are lock free (two dependent loads) and may run concurrently with insert().
+// writers must be serialized by the caller. leaves are only released by the destructor,
+// so a reader never touches freed map memory.
+//
+// the root (2 MiB) and every leaf (2 MiB, covering 1 GiB of address space) are reserved with mmap,
+// so only the pages that are actually written become resident.
+//
+class page_map
+{
+public:
+    static constexpr size_t page_shift = 12;
+    static constexpr size_t address_bits = 48;
+    static constexpr size_t leaf_bits = 18;
+    static constexpr size_t root_bits = address_bits - page_shift - leaf_bits;
+
+    page_map() = default;
+    ~page_map();
+
+    page_map(const page_map&) = delete;
+    page_map& operator=(const page_map&) = delete;
+    page_map(page_map&&) = delete;
+    page_map& operator=(page_map&&) = delete;
+
+    // maps every page overlapping [begin, end) to owner.
+    // NOT thread safe against other writers
+    // returns: false if a leaf could not be mapped or the range lies outside the 48 bit address space.
+    // an empty range is a no-op that succeeds
+    [[nodiscard]] bool insert(const void* begin, const void* end, void* owner);
+
+#ifdef PALLOC_TESTING
+    // when nonzero, counts down on every insert() of the calling thread and fails the one that reaches zero
+    static inline thread_local size_t fail_insert_countdown = 0;
+#endif
+
+    // clears every page overlapping [begin, end).
+    // NOT thread safe against other writers
+    void erase(const void* begin, const void* end);
+
+    // returns: the owner of the page containing ptr, or nullptr if the page was never inserted
+    void* find(const void* ptr) const
+    {
+        uintptr_t page = reinterpret_cast<uintptr_t>(ptr) >> page_shift;
+        if (page >> (root_bits + leaf_bits)) [[unlikely]]
+            return nullptr;
+
+        const std::atomic<leaf*>* r = root.load(std::memory_order_acquire);
+        if (r == nullptr)
+            return nullptr;
+
+        const leaf* l = r[page >> leaf_bits].load(std::memory_order_acquire);
+        if (l == nullptr)
+            return nullptr;
+
+        return l->owners[page & (leaf_size - 1)].load(std::memory_order_acquire);
+    }
+
+private:
+    static constexpr size_t root_size = size_t{1} << root_bits;
+    static constexpr size_t leaf_size = size_t{1} << leaf_bits;
+
+    struct leaf
+    {
+        std::atomic<void*> owners[leaf_size];
+    };
+
+    // mapped by the first insert, so an unused map costs no memory
+    std::atomic<std::atomic<leaf*>*> root{nullptr};
+
+    // returns: the leaf for the given root index, mapping it if needed. nullptr if mmap failed
+    leaf* get_or_create_leaf(size_t index);
+};
+
+} // namespace AL
@@ -9,6 +9,11 @@
 #include <unistd.h>
 #endif
 
+#ifdef __linux__
+#include <linux/membarrier.h>
+#include <sys/syscall.h>
+#endif
+
 inline constexpr bool palloc_is_windows =
 #ifdef _WIN32
     true;
@@ -45,6 +50,94 @@ struct platform_mem
 #endif
     }
 
+    // reserves address space without backing it. nothing in the range can be touched until commit()
+    // returns: nullptr if failed. release it with free()
+    [[nodiscard]] static void* reserve(std::size_t size) noexcept
+    {
+#ifdef _WIN32
+        return VirtualAlloc(nullptr, size, MEM_RESERVE, PAGE_NOACCESS);
+#else
+        void* ptr = mmap(nullptr, size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        return ptr == MAP_FAILED ? nullptr : ptr;
+#endif
+    }
+
+    // makes [ptr, ptr + size) of a reserved range readable and writable. ptr and size must be page aligned
+    static bool commit(void* ptr, std::size_t size) noexcept
+    {
+#ifdef _WIN32
+        return VirtualAlloc(ptr, size, MEM_COMMIT, PAGE_READWRITE) != nullptr;
+#else
+        return mprotect(ptr, size, PROT_READ | PROT_WRITE) == 0;
+#endif
+    }
+
+    // returns committed pages to the reserved state: their memory and commit charge are dropped and
+    // touching them faults again. ptr and size must be page aligned
+    static bool decommit(void* ptr, std::size_t size) noexcept
+    {
+#ifdef _WIN32
+        return VirtualFree(ptr, size, MEM_DECOMMIT) != 0;
+#else
+        // mapping over the range drops the pages and the charge in one step
+        void* res = mmap(ptr, size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_FIXED, -1, 0);
+        return res != MAP_FAILED;
+#endif
+    }
+
+    // resizes a mapping made by alloc(). it may move, and its contents are only kept on linux (mremap),
+    // elsewhere it is a fresh mapping. returns: nullptr if failed, the old mapping is then left as it was
+    [[nodiscard]] static void* resize(void* ptr, std::size_t old_size, std::size_t new_size) noexcept
+    {
+#ifdef __linux__
+        void* res = mremap(ptr, old_size, new_size, MREMAP_MAYMOVE);
+        return res == MAP_FAILED ? nullptr : res;
+#else
+        void* res = alloc(new_size);
+        if (res != nullptr)
+            free(ptr, old_size);
+        return res;
+#endif
+    }
+
+    // tells the OS the contents of [ptr, ptr + size) are no longer needed, so the pages stop counting
+    // towards the resident set. the range stays mapped and writable. ptr and size must be page aligned
+    static bool purge(void* ptr, std::size_t size) noexcept
+    {
+#ifdef _WIN32
+        return VirtualAlloc(ptr, size, MEM_RESET, PAGE_READWRITE) != nullptr;
+#else
+        return madvise(ptr, size, MADV_DONTNEED) == 0;
+#endif
+    }
+
+    // bytes of [ptr, ptr + size) that are resident. ptr must be page aligned.
+    // windows has no cheap query, there every committed byte is reported
+    static std::size_t resident(void* ptr, std::size_t size) noexcept
+    {
+#ifdef _WIN32
+        (void)ptr;
+        return size;
+#else
+        const std::size_t page = page_size();
+        const std::size_t pages = (size + page - 1) / page;
+
+        // no heap here, so query a window of pages at a time
+        constexpr std::size_t window = 4096;
+        unsigned char vec[window];
+        std::size_t count = 0;
+        for (std::size_t first = 0; first < pages; first += window)
+        {
+            const std::size_t n = pages - first < window ? pages - first : window;
+            if (mincore(static_cast<char*>(ptr) + first * page, n * page, vec) != 0)
+                return 0;
+            for (std::size_t i = 0; i < n; i++)
+                count += vec[i] & 1;
+        }
+        return count * page;
+#endif
+    }
+
     static std::size_t page_size() noexcept
     {
 #ifdef _WIN32
@@ -57,4 +150,34 @@ struct platform_mem
     }
 };
 
+//
+// process wide memory barrier for asymmetric synchronization: a hot reader side that only needs a
+// compiler barrier, and a rare writer side that pays for forcing a full barrier on every running thread.
+// membarrier on linux, FlushProcessWriteBuffers on windows.
+//
+struct platform_fence
+{
+    // must succeed once before heavy() is used.
+    // returns: false if the system has no process wide barrier, readers then need a real fence
+    [[nodiscard]] static bool init() noexcept
+    {
+#ifdef _WIN32
+        return true;
+#elif defined(__linux__)
+        return syscall(SYS_membarrier, MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED, 0, 0) == 0;
+#else
+        return false;
+#endif
+    }
+
+    static void heavy() noexcept
+    {
+#ifdef _WIN32
+        FlushProcessWriteBuffers();
+#elif defined(__linux__)
+        syscall(SYS_membarrier, MEMBARRIER_CMD_PRIVATE_EXPEDITED, 0, 0);
+#endif
+    }
+};
+
 } // namespace AL
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "stats.h"
 #include <atomic>
 #include <cstddef>
 #include <mutex>
@@ -64,6 +65,9 @@ public:
     size_t get_block_count() const;
     void clear();
 
+    // snapshot of the pool's counters. counters are zero unless built with PALLOC_STATS
+    pool_stats stats() const;
+
     std::byte* get_memory_start() const { return memory; }
     std::byte* get_memory_end() const { return memory + capacity; }
 
@@ -77,6 +81,11 @@ private:
     free_node* free_list;
     mutable std::mutex alloc_free_mutex;
 
+    // only written while holding alloc_free_mutex
+    stat_counter stat_allocs;
+    stat_counter stat_frees;
+    stat_counter stat_exhausted;
+
     bool owns(void* ptr) const;
     void init_free_list();
 
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+
+namespace AL
+{
+
+#if PALLOC_PROFILING
+inline constexpr bool profiling_enabled = true;
+#else
+inline constexpr bool profiling_enabled = false;
+#endif
+
+//
+// sampling heap profiler for slab and dynamic_slab.
+// roughly one allocation per sample_rate bytes is recorded with its backtrace and kept in a live table
+// until it is freed, so a dump shows which call sites hold memory right now.
+// only compiled in with PALLOC_PROFILING, and idle until a sample rate is set.
+//
+class heap_profiler
+{
+public:
+    static constexpr size_t max_frames = 32;
+
+    // mean number of allocated bytes between two samples. 0 turns sampling off (the default).
+    // the calling thread uses the new rate immediately, other threads once their current countdown runs out
+    static void set_sample_rate(size_t bytes);
+    static size_t get_sample_rate();
+
+    // number of sampled allocations that have not been freed yet
+    static size_t get_live_samples();
+
+    // samples that could not be recorded because the live table was full
+    static size_t get_dropped_samples();
+
+    // writes the live samples in the gperftools heap profile format, readable by `pprof <binary> <file>`
+    static void write_pprof(std::ostream& out);
+
+    // writes the live samples as collapsed stacks ("root;...;leaf bytes") for flamegraph.pl or speedscope.
+    // byte counts are unsampled estimates. frames are named with dladdr, so link with -rdynamic for readable names
+    static void write_collapsed(std::ostream& out);
+
+    // forgets every live sample. use after slab::reset() or destroying an allocator that still had sampled blocks
+    static void clear();
+
+    // called by the allocators on every alloc. the unsampled path is a single thread local subtraction
+    static void on_alloc(void* ptr, size_t size)
+    {
+#if PALLOC_PROFILING
+        bytes_until_sample -= static_cast<int64_t>(size);
+        if (bytes_until_sample < 0) [[unlikely]]
+            record(ptr, size);
+#else
+        (void)ptr;
+        (void)size;
+#endif
+    }
+
+    // called by the allocators on every free. one shared load while nothing is sampled,
+    // plus one filter lookup while samples are live
+    static void on_free(void* ptr)
+    {
+#if PALLOC_PROFILING
+        if (live_count.load(std::memory_order_relaxed) == 0)
+            return;
+        if (filter[filter_index(ptr)].load(std::memory_order_relaxed) != 0) [[unlikely]]
+            forget(ptr);
+#else
+        (void)ptr;
+#endif
+    }
+
+private:
+#if PALLOC_PROFILING
+    static constexpr size_t filter_bits = 16;
+
+    // counting filter over sampled addresses. a zero slot proves the pointer was never sampled
+    static inline std::array<std::atomic<uint8_t>, (size_t{1} << filter_bits)> filter{};
+    static inline std::atomic<size_t> live_count{0};
+
+    // bytes left before this thread takes its next sample
+    static inline thread_local int64_t bytes_until_sample = 0;
+
+    static size_t filter_index(void* ptr)
+    {
+        // fibonacci hashing. drop the low bits, every block is at least 8 byte aligned
+        uint64_t key = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(ptr)) >> 3;
+        return static_cast<size_t>((key * 0x9E3779B97F4A7C15ull) >> (64 - filter_bits));
+    }
+
+    static void record(void* ptr, size_t size);
+    static void forget(void* ptr);
+#endif
+};
+
+} // namespace AL
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "arena.h"
+#include "slab.h"
+#include "stats.h"
+#include <array>
+#include <cstddef>
+
+namespace AL
+{
+//
+// a heap for the lifetime of one request. blocks are carved out of an arena in slab's size classes,
+// and free() pushes a block onto its class's free list so the next alloc() of that class reuses it.
+// reset() drops every block at once: it clears the free list heads and resets the arena.
+// meant to be owned by one request at a time
+// NOT thread safe
+//
+class request_heap
+{
+public:
+    // bytes is the backing arena's capacity, rounded up to a page boundary
+    explicit request_heap(size_t bytes);
+
+    request_heap(const request_heap&) = delete;
+    request_heap& operator=(const request_heap&) = delete;
+
+    // allocates a block of at least length bytes. a free block of the size class is reused first.
+    // lengths above slab's largest class, or alignments above default_alignment, come straight
+    // from the arena and are only reclaimed by reset()
+    // returns: nullptr if failed, else the memory address of the block of memory
+    [[nodiscard]] void* alloc(size_t length, size_t alignment = default_alignment);
+
+    // same as alloc, also zeroes out the memory returned
+    [[nodiscard]] void* calloc(size_t length, size_t alignment = default_alignment);
+
+    // returns a block to its size class. length and alignment must be the ones it was allocated with
+    void free(void* ptr, size_t length, size_t alignment = default_alignment);
+
+    static constexpr size_t default_alignment = alignof(std::max_align_t);
+
+    // frees every block. O(1) apart from arena::reset()'s work, no block is visited
+    // returns: -1 if failed
+    int reset();
+
+    // bytes carved from the arena, free blocks included
+    size_t get_used() const;
+
+    size_t get_capacity() const;
+
+    // snapshot of the heap's counters. counters are zero unless built with PALLOC_STATS
+    request_heap_stats stats() const;
+
+private:
+    // returns: the size class of max(length, alignment), or -1 for the arena directly
+    static size_t class_index(size_t length, size_t alignment);
+
+    struct free_block
+    {
+        free_block* next;
+    };
+
+    arena backing;
+    std::array<free_block*, slab::size_class_count()> free_lists{};
+
+    stat_counter stat_recycled;
+    stat_counter stat_frees;
+    stat_counter stat_failed;
+    stat_counter stat_resets;
+};
+} // namespace AL
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace AL
+{
+//
+// short-lived scratch memory on the calling thread. every thread has its own bump region, mapped on
+// first use, and a scratch_scope rewinds it to where it was when the scope opened:
+//
+//     scratch_scope s;
+//     auto* p = static_cast<char*>(s.alloc(n));
+//
+// allocation is a thread local bump with no atomics and no mapping per call. scopes nest and must be
+// closed in reverse order, so they belong on the stack. memory from a scope is only valid on the
+// thread that allocated it and until the scope closes
+//
+class scratch_scope
+{
+public:
+    // bytes mapped per thread unless set_thread_reserve() says otherwise
+    static constexpr size_t default_reserve = size_t(1) << 20; // 1 MiB
+
+    static constexpr size_t default_alignment = alignof(std::max_align_t);
+
+    scratch_scope() noexcept : saved(state.used)
+    {}
+
+    ~scratch_scope()
+    {
+        state.used = saved;
+    }
+
+    scratch_scope(const scratch_scope&) = delete;
+    scratch_scope& operator=(const scratch_scope&) = delete;
+
+    // allocates from the calling thread's scratch region. the region does not grow: once the
+    // thread's reserve is used up by the open scopes, allocation fails
+    // alignment must be a power of two, see arena::alloc()
+    // returns: nullptr if failed, else the memory address of the block of memory
+    [[nodiscard]] void* alloc(size_t length, size_t alignment = default_alignment)
+    {
+        if (length == 0 || !std::has_single_bit(alignment))
+            return nullptr;
+
+        // an unmapped region has capacity 0 and takes the slow path
+        const uintptr_t base = reinterpret_cast<uintptr_t>(state.memory);
+        const size_t aligned = ((base + state.used + alignment - 1) & ~(alignment - 1)) - base;
+        if (aligned > state.capacity || length > state.capacity - aligned)
+            return alloc_slow(length, alignment);
+
+        state.used = aligned + length;
+        return state.memory + aligned;
+    }
+
+    // same as alloc, also zeroes out the memory returned
+    [[nodiscard]] void* calloc(size_t length, size_t alignment = default_alignment)
+    {
+        void* ptr = alloc(length, alignment);
+
+        if (ptr != nullptr)
+        {
+            std::memset(ptr, 0, length);
+        }
+
+        return ptr;
+    }
+
+    // sets the size of the calling thread's scratch region, rounded up to a page boundary. a region that
+    // is already mapped is unmapped, and the next alloc() maps one of the new size
+    // returns: -1 if a scope on this thread still holds scratch memory
+    static int set_thread_reserve(size_t bytes);
+
+    // bytes the calling thread's open scopes hold
+    static size_t get_thread_used();
+
+    // size of the calling thread's region, 0 until its first alloc()
+    static size_t get_thread_capacity();
+
+private:
+    // maps the region on first use, then retries the bump
+    static void* alloc_slow(size_t length, size_t alignment);
+
+    struct thread_state
+    {
+        std::byte* memory = nullptr;
+        size_t used = 0;
+        size_t capacity = 0;
+        size_t reserve = default_reserve;
+    };
+
+    // constant initialized and trivially destructible, so access needs no guard. the mapping is
+    // released at thread exit by a separate thread local in scratch.cpp
+    static constinit thread_local thread_state state;
+
+    size_t saved;
+};
+} // namespace AL
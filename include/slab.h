@@ -1,12 +1,15 @@
 #pragma once
 
 #include "pool.h"
+#include "stats.h"
 #include <array>
 #include <atomic>
 #include <bit>
 #include <cassert>
 #include <cstddef>
 #include <iterator>
+#include <mutex>
+#include <type_traits>
 #include <utility>
 
 namespace AL
@@ -19,6 +22,7 @@ struct thread_local_cache
     std::array<void*, object_count> objects;
     size_t current = 0;
     size_t batch_size = object_count / 2; // filled by slab on cache init
+    [[no_unique_address]] tlc_counters counters;
 
     [[nodiscard]] void* try_pop()
     {
@@ -26,6 +30,7 @@ struct thread_local_cache
             return nullptr;
 
         current--;
+        counters.track(current);
         return objects[current];
     }
 
@@ -35,6 +40,7 @@ struct thread_local_cache
 
         objects[current] = ptr;
         current++;
+        counters.track(current);
     }
 
     bool is_empty() const
@@ -50,6 +56,7 @@ struct thread_local_cache
     void invalidate()
     {
         current = 0;
+        counters.track(current);
     }
 };
 
@@ -58,6 +65,10 @@ class slab
 public:
     // scale is multiplied by the default number of blocks to allocate
     slab(size_t scale = 1.0);
+
+    // detaches the cache entries every thread holds for this slab, so no thread ever hands out
+    // or flushes blocks of it afterwards, even if a new slab is created at the same address.
+    // other threads may keep running, as long as none of them still uses this slab
     ~slab();
 
     slab(const slab&) = delete;
@@ -73,7 +84,7 @@ public:
     // returns memory is properly aligned
     [[nodiscard]] void* calloc(size_t size);
 
-    // NOT thread safe
+    // NOT thread safe. drops the blocks every thread caches for this slab
     // returns: -1 if failed
     void reset();
 
@@ -86,9 +97,41 @@ public:
     size_t get_pool_block_size(size_t index) const;
     size_t get_pool_free_space(size_t index) const;
 
+    // memory range backing the pool at index. nullptr if index is out of range
+    std::byte* get_pool_memory_start(size_t index) const;
+    std::byte* get_pool_memory_end(size_t index) const;
+
     // check if pointer belongs to this slab
     bool owns(void* ptr) const;
 
+    // true when every block is back in the shared pools, i.e. nothing is allocated
+    // and no thread local cache holds blocks of this slab
+    bool is_unused() const;
+
+    // returns the blocks the calling thread caches for this slab to the shared pools
+    void flush_thread_cache();
+
+    // takes up to count blocks of size class index straight from its shared pool, bypassing the thread cache.
+    // for callers that keep their own cache (dynamic_slab)
+    // returns: number of blocks written to out
+    size_t alloc_batch(size_t index, size_t count, void** out);
+
+    // returns count blocks of size class index straight to its shared pool
+    void free_batch(size_t index, size_t count, void** blocks);
+
+    // snapshot of pool and thread local cache counters, aggregated over every thread on demand.
+    // counters are zero unless built with PALLOC_STATS
+    slab_stats stats() const;
+
+    // calls fn(const thread_cache_stats&) once for every live thread that caches blocks of this slab.
+    // fn runs under this slab's registry lock and must not call back into stats().
+    // does nothing unless built with PALLOC_STATS
+    template<typename F>
+    void for_each_thread_cache(F&& fn) const
+    {
+        visit_thread_caches([](const thread_cache_stats& s, void* ctx) { (*static_cast<std::remove_reference_t<F>*>(ctx))(s); }, &fn);
+    }
+
     static constexpr size_t size_to_index(size_t size)
     {
         if (size == 0 || size > SIZE_CLASS_CONFIG[NUM_SIZE_CLASSES - 1].first)
@@ -99,6 +142,11 @@ public:
         return std::bit_width(std::bit_ceil(s)) - std::bit_width(SIZE_CLASS_CONFIG[0].first);
     }
 
+    static constexpr size_t size_class_count()
+    {
+        return NUM_SIZE_CLASSES;
+    }
+
     static constexpr size_t index_to_size_class(size_t index)
     {
         if (index >= NUM_SIZE_CLASSES)
@@ -106,6 +154,17 @@ public:
         return SIZE_CLASS_CONFIG[index].first;
     }
 
+    // blocks a thread local cache moves per refill or flush for this size class
+    static constexpr size_t index_to_batch_size(size_t index)
+    {
+        if (index >= NUM_SIZE_CLASSES)
+            return 0;
+        return BATCH_SIZES[index];
+    }
+
+    // bytes the pools of a slab constructed with this scale map, i.e. its get_total_capacity()
+    static size_t capacity_for_scale(size_t scale);
+
 private:
     // compile-time size class configuration
     // <bytes class, number of blocks in class>
@@ -122,6 +181,7 @@ private:
          {4096, 32}}
     };
     static_assert(SIZE_CLASS_CONFIG.size() > 0, "Atleast one entry in SIZE_CLASS_CONFIG required.");
+    static_assert(SIZE_CLASS_CONFIG.size() == stats_size_classes, "stats_size_classes must match SIZE_CLASS_CONFIG.");
 
     static constexpr size_t MAX_CACHED_SLABS = 4;
     static constexpr size_t NUM_SIZE_CLASSES = std::size(SIZE_CLASS_CONFIG);
@@ -147,15 +207,26 @@ private:
                   "The number of cached classes must be lower than the amount of size classes available. "
                   "Either decrease the cached classes or increase total number of size classes.");
 
+    struct thread_registration;
+
     struct cache_entry
     {
         size_t epoch;
-        slab* owner;
+        // atomic so other threads can inspect the entry (stats). only the owning thread
+        // and slab teardown ever write it
+        std::atomic<slab*> owner;
         std::array<thread_local_cache, slab::NUM_CACHED_CLASSES> storage;
 
+        // links in the owner's registry, and the thread this entry belongs to.
+        // written under the owner's registry_mutex
+        cache_entry* registry_prev = nullptr;
+        cache_entry* registry_next = nullptr;
+        thread_registration* thread = nullptr;
+
         void flush()
         {
-            if (!owner)
+            slab* current_owner = owner.load(std::memory_order_relaxed);
+            if (!current_owner)
                 return; // should we assert?
 
             for (size_t i = 0; i < NUM_CACHED_CLASSES; i++)
@@ -165,14 +236,15 @@ private:
                 if (cache.is_empty())
                     continue;
 
-                owner->shared_pools[i].free_batched_internal(cache.current, cache.objects.data());
-                cache.current = 0;
+                current_owner->shared_pools[i].free_batched_internal(cache.current, cache.objects.data());
+                cache.counters.on_flush();
+                cache.invalidate();
             }
         }
 
         void invalidate_all()
         {
-            if (!owner)
+            if (!owner.load(std::memory_order_relaxed))
                 return;
 
             for (size_t i = 0; i < NUM_CACHED_CLASSES; i++)
@@ -188,19 +260,21 @@ private:
 
         // O(1) fast path: check the preferred hash slot first
         const size_t preferred = slab_id % MAX_CACHED_SLABS;
-        if (caches[preferred].owner == this)
+        if (caches[preferred].owner.load(std::memory_order_relaxed) == this)
             return &caches[preferred];
 
         // Scan for an existing entry for this slab, or the first empty slot.
         // Slabs with colliding hash IDs will land in different slots when space is available.
-        size_t empty_slot = caches[preferred].owner == nullptr ? preferred : (size_t)-1;
+        // acquire pairs with the release store in ~slab() when another thread emptied a slot
+        size_t empty_slot = caches[preferred].owner.load(std::memory_order_acquire) == nullptr ? preferred : (size_t)-1;
         for (size_t i = 0; i < MAX_CACHED_SLABS; ++i)
         {
             if (i == preferred)
                 continue;
-            if (caches[i].owner == this)
+            slab* owner = caches[i].owner.load(std::memory_order_acquire);
+            if (owner == this)
                 return &caches[i];
-            if (caches[i].owner == nullptr && empty_slot == (size_t)-1)
+            if (owner == nullptr && empty_slot == (size_t)-1)
                 empty_slot = i;
         }
 
@@ -208,7 +282,7 @@ private:
         if (empty_slot != (size_t)-1)
         {
             cache_entry& entry = caches[empty_slot];
-            entry.owner = this;
+            attach(entry, register_thread());
             entry.epoch = epoch.load(std::memory_order_acquire);
             init_cache_batch_sizes(entry);
             return &entry;
@@ -219,13 +293,26 @@ private:
         // slots are 0..MAX_CACHED_SLABS-2 remain stable across round-robin cycling.
         // This mirrors LRU-ish eviction: the last slot acts as the "victim" slot.
         cache_entry& entry = caches[MAX_CACHED_SLABS - 1];
-        entry.flush();
-        entry.owner = this;
+        evict(entry);
         entry.epoch = epoch.load(std::memory_order_acquire);
         init_cache_batch_sizes(entry);
         return &entry;
     }
 
+    // flushes the entry back to its current owner and hands it to this slab
+    void evict(cache_entry& entry);
+
+    // links entry into this slab's registry and makes this slab its owner
+    void attach(cache_entry& entry, thread_registration& thread);
+
+    // returns the blocks entry caches to the pools (drops them if a reset() made them stale),
+    // unlinks it from this slab's registry and clears its owner. must hold the entry's thread lock
+    void detach(cache_entry& entry);
+
+    // calls fn(cache_entry&) for every registered entry while holding registry_mutex and the entry's thread lock
+    template<typename F>
+    void for_each_registered_entry(F&& fn);
+
     static void init_cache_batch_sizes(cache_entry& entry)
     {
         for (size_t i = 0; i < NUM_CACHED_CLASSES; ++i)
@@ -237,6 +324,22 @@ private:
 
     static std::atomic<size_t> next_slab_id;
     size_t slab_id;
+
+    stat_counter stat_evictions;
+
+    // counters of thread caches that were evicted or whose thread exited
+    std::array<tlc_counters, NUM_SIZE_CLASSES> retired_counters;
+
+    // cache entries of every thread that currently caches blocks of this slab, so teardown, reset()
+    // and stats can reach them without stopping the world.
+    // lock order: a thread's lock before registry_mutex. the other direction only try_locks
+    mutable std::mutex registry_mutex;
+    cache_entry* registered = nullptr;
+
+    // created the first time the calling thread claims a cache entry. on thread exit it
+    // returns every entry's blocks to its owner
+    static thread_registration& register_thread();
+    void visit_thread_caches(void (*fn)(const thread_cache_stats&, void*), void* ctx) const;
 };
 
 } // namespace AL
@@ -0,0 +1,297 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace AL
+{
+
+#if PALLOC_STATS
+inline constexpr bool stats_enabled = true;
+#else
+inline constexpr bool stats_enabled = false;
+#endif
+
+// number of slab size classes reported in a snapshot. slab static_asserts that this matches its config
+inline constexpr size_t stats_size_classes = 10;
+
+//
+// a counter that only exists when the library is built with PALLOC_STATS.
+// when stats are disabled every member is an empty inline function so the calls compile away.
+//
+struct stat_counter
+{
+#if PALLOC_STATS
+    // single writer only (owning thread, or the caller holds a lock).
+    // avoids a locked read-modify-write so thread-local counters stay as cheap as a plain increment
+    void add(uint64_t n = 1) noexcept
+    {
+        value.store(value.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+    // for counters written by many threads at once
+    void shared_add(uint64_t n = 1) noexcept
+    {
+        value.fetch_add(n, std::memory_order_relaxed);
+    }
+
+    void set(uint64_t n) noexcept
+    {
+        value.store(n, std::memory_order_relaxed);
+    }
+
+    uint64_t get() const noexcept
+    {
+        return value.load(std::memory_order_relaxed);
+    }
+
+private:
+    std::atomic<uint64_t> value{0};
+#else
+    void add(uint64_t = 1) noexcept
+    {}
+
+    void shared_add(uint64_t = 1) noexcept
+    {}
+
+    void set(uint64_t) noexcept
+    {}
+
+    uint64_t get() const noexcept
+    {
+        return 0;
+    }
+#endif
+};
+
+//
+// counters kept inside every thread local cache (one per size class per thread).
+// written only by the owning thread, read by other threads when a snapshot is taken.
+// empty when stats are disabled so it adds nothing to the cache layout.
+//
+struct tlc_counters
+{
+#if PALLOC_STATS
+    void on_hit() noexcept
+    {
+        hits.add();
+    }
+
+    void on_refill() noexcept
+    {
+        refills.add();
+    }
+
+    void on_flush() noexcept
+    {
+        flushes.add();
+    }
+
+    // mirrors thread_local_cache::current so other threads can read it without racing
+    void track(size_t current) noexcept
+    {
+        cached.set(current);
+    }
+
+    // folds another thread's counters into this one. cached blocks are not carried over
+    void absorb(const tlc_counters& other) noexcept
+    {
+        hits.add(other.hits.get());
+        refills.add(other.refills.get());
+        flushes.add(other.flushes.get());
+    }
+
+    void clear() noexcept
+    {
+        hits.set(0);
+        refills.set(0);
+        flushes.set(0);
+        cached.set(0);
+    }
+
+    uint64_t hit_count() const noexcept
+    {
+        return hits.get();
+    }
+
+    uint64_t refill_count() const noexcept
+    {
+        return refills.get();
+    }
+
+    uint64_t flush_count() const noexcept
+    {
+        return flushes.get();
+    }
+
+    size_t cached_blocks() const noexcept
+    {
+        return static_cast<size_t>(cached.get());
+    }
+
+private:
+    stat_counter hits;
+    stat_counter refills;
+    stat_counter flushes;
+    stat_counter cached;
+#else
+    void on_hit() noexcept
+    {}
+
+    void on_refill() noexcept
+    {}
+
+    void on_flush() noexcept
+    {}
+
+    void track(size_t) noexcept
+    {}
+
+    void absorb(const tlc_counters&) noexcept
+    {}
+
+    void clear() noexcept
+    {}
+
+    uint64_t hit_count() const noexcept
+    {
+        return 0;
+    }
+
+    uint64_t refill_count() const noexcept
+    {
+        return 0;
+    }
+
+    uint64_t flush_count() const noexcept
+    {
+        return 0;
+    }
+
+    size_t cached_blocks() const noexcept
+    {
+        return 0;
+    }
+#endif
+};
+
+// snapshot types
+// every counter is zero when the library is built without PALLOC_STATS.
+// structural values (capacity, free space) are always filled in
+
+struct arena_stats
+{
+    size_t used = 0;
+    size_t capacity = 0;
+    uint64_t failed_allocs = 0;
+    uint64_t resets = 0;
+    uint64_t chunk_refills = 0; // thread chunks reserved, see arena::set_thread_chunk_size()
+    uint64_t rollbacks = 0;
+    uint64_t purged_bytes = 0; // returned to the OS by reset(), see arena::set_retained_bytes()
+    size_t used_top = 0;       // see arena::alloc_top()
+    uint64_t in_place_extends = 0; // try_extend() calls that grew a block without moving it
+    uint64_t resizes = 0;          // capacity changes made by reset(), see arena::set_auto_size()
+};
+
+struct generational_arena_stats
+{
+    size_t used = 0;
+    size_t capacity = 0;
+    uint64_t generation = 0;
+    uint64_t failed_allocs = 0;
+    uint64_t resets = 0;
+    uint64_t reset_retries = 0; // allocs that lost their CAS to a reset() and retried in the new generation
+};
+
+struct frame_arena_stats
+{
+    uint64_t frame = 0;
+    size_t used = 0; // current frame
+    size_t capacity = 0;
+    size_t last_frame_used = 0; // bytes the last completed frame ended with
+    size_t peak_frame_used = 0; // most any completed frame ended with
+    uint64_t failed_allocs = 0;
+};
+
+struct request_heap_stats
+{
+    size_t used = 0; // bytes carved from the arena
+    size_t capacity = 0;
+    uint64_t recycled = 0; // allocs served from a free list
+    uint64_t frees = 0;
+    uint64_t failed_allocs = 0;
+    uint64_t resets = 0;
+};
+
+struct chained_arena_stats
+{
+    size_t used = 0;
+    size_t capacity = 0;
+    size_t blocks = 0;
+    uint64_t grows = 0; // blocks linked because the current one was full
+    uint64_t failed_allocs = 0;
+    uint64_t resets = 0;
+};
+
+struct vm_arena_stats
+{
+    size_t used = 0;
+    size_t committed = 0;
+    size_t reserved = 0;
+    uint64_t commits = 0; // commit steps taken as the offset advanced
+    uint64_t failed_allocs = 0;
+    uint64_t resets = 0;
+};
+
+struct pool_stats
+{
+    size_t block_size = 0;
+    size_t block_count = 0;
+    size_t free_blocks = 0;
+    uint64_t allocs = 0;    // blocks handed out, including batched refills
+    uint64_t frees = 0;     // blocks returned, including batched flushes
+    uint64_t exhausted = 0; // alloc requests that could not be fully satisfied
+};
+
+struct slab_class_stats
+{
+    pool_stats pool;
+    uint64_t tlc_hits = 0;    // allocations served straight from a thread local cache
+    uint64_t tlc_refills = 0; // cache misses that went to the shared pool
+    uint64_t tlc_flushes = 0; // batches written back to the shared pool
+    size_t cached_bytes = 0;  // bytes sitting in thread local caches across all threads
+};
+
+struct slab_stats
+{
+    size_t capacity = 0;
+    size_t free_bytes = 0;   // bytes free in the shared pools
+    size_t cached_bytes = 0; // bytes free but held by thread local caches
+    size_t thread_caches = 0;
+    uint64_t cache_evictions = 0; // times get_cached_slab() had to evict another slab to make room
+    std::array<slab_class_stats, stats_size_classes> classes{};
+};
+
+// per-thread view reported through slab::for_each_thread_cache()
+struct thread_cache_stats
+{
+    uint64_t thread_id = 0; // registration order, not the os thread id
+    size_t total_bytes = 0;
+    std::array<size_t, stats_size_classes> cached_bytes{};
+};
+
+struct dynamic_slab_stats
+{
+    size_t node_count = 0;
+    uint64_t grows = 0;
+    uint64_t grow_failures = 0;
+    uint64_t releases = 0; // slab nodes unmapped after becoming empty
+    size_t mapped_bytes = 0; // pools and node headers, see dynamic_slab::set_memory_limits()
+    uint64_t soft_limit_hits = 0; // grows that had to reclaim first
+    uint64_t hard_limit_failures = 0; // grows refused by the hard limit, also counted in grow_failures
+    slab_stats slabs; // summed over every node
+};
+
+} // namespace AL
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "stats.h"
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+
+namespace AL
+{
+//
+// a bump arena over one reserved range of address space that is committed in steps as the offset
+// advances. allocations never move and never chain, and resident memory follows what was used,
+// so the reservation can be sized for the worst case without paying for it.
+// allocation is the same CAS as arena::alloc; only crossing into uncommitted pages takes a lock
+//
+class vm_arena
+{
+public:
+    static constexpr size_t default_reserve = size_t(64) << 30;  // 64 GiB
+    static constexpr size_t default_commit_step = size_t(2) << 20; // 2 MiB
+
+    // reserve_bytes and commit_step are rounded up to a page boundary. nothing is committed up front
+    explicit vm_arena(size_t reserve_bytes = default_reserve, size_t commit_step = default_commit_step);
+    ~vm_arena();
+
+    vm_arena(const vm_arena&) = delete;
+    vm_arena& operator=(const vm_arena&) = delete;
+    vm_arena(vm_arena&&) = delete;
+    vm_arena& operator=(vm_arena&&) = delete;
+
+    // allocates a block of memory of specified length, committing more of the reservation if needed
+    // alignment must be a power of two, see arena::alloc()
+    // returns: nullptr if failed, else the memory address of the block of memory
+    [[nodiscard]] void* alloc(size_t length, size_t alignment = default_alignment);
+
+    // same as alloc, also zeroes out the memory returned
+    [[nodiscard]] void* calloc(size_t length, size_t alignment = default_alignment);
+
+    static constexpr size_t default_alignment = alignof(std::max_align_t);
+
+    // frees the entire arena. committed pages above the retained size are decommitted
+    // NOT thread safe
+    // returns: -1 if failed
+    int reset();
+
+    // reset() keeps at most `bytes` committed. SIZE_MAX (the default) keeps everything committed so far
+    void set_retained_bytes(size_t bytes);
+
+    // gets the amount of bytes used by the arena
+    size_t get_used() const;
+
+    // bytes that are committed, i.e. backed and counted against the commit limit
+    size_t get_committed() const;
+
+    // size of the reserved range, the most the arena can ever hold
+    size_t get_reserved() const;
+
+    // snapshot of the arena's counters. counters are zero unless built with PALLOC_STATS
+    vm_arena_stats stats() const;
+
+private:
+    // commits whole steps until at least end bytes are committed. takes commit_mutex
+    bool commit_to(size_t end);
+
+    std::byte* memory;
+    std::atomic<size_t> used;
+    // only grows between resets. written under commit_mutex
+    std::atomic<size_t> committed;
+    const size_t reserved;
+    const size_t commit_step;
+    size_t retained_bytes;
+    std::mutex commit_mutex;
+
+    stat_counter stat_commits;
+    stat_counter stat_failed;
+    stat_counter stat_resets;
+};
+} // namespace AL
@@ -1,6 +1,8 @@
 #include "arena.h"
 #include "platform.h"
+#include <algorithm>
 #include <atomic>
+#include <bit>
 #include <cassert>
 #include <cstddef>
 #include <cstring>
@@ -9,7 +11,11 @@
 
 namespace AL
 {
-arena::arena(size_t bytes) : memory(nullptr), used(0), capacity(0)
+thread_local std::array<arena::thread_chunk, arena::max_thread_chunks> arena::chunks = {};
+std::atomic<uint64_t> arena::next_generation{1};
+
+arena::arena(size_t bytes)
+    : generation(next_generation.fetch_add(1, std::memory_order_relaxed)), chunk_size(0), memory(nullptr), used(0), top(0), capacity(0)
 {
     size_t page_size = AL::platform_mem::page_size();
 
@@ -24,7 +30,9 @@ arena::arena(size_t bytes) : memory(nullptr), used(0), capacity(0)
     }
 
     memory = static_cast<std::byte*>(ptr);
+    mapped = capacity;
     used = 0;
+    top = capacity;
 }
 
 arena::~arena()
@@ -32,7 +40,9 @@ arena::~arena()
     if (memory == nullptr)
         return;
 
-    bool freed = AL::platform_mem::free(memory, capacity);
+    run_destructors(memory);
+
+    bool freed = AL::platform_mem::free(memory, mapped);
 
 #if PALLOC_DEBUG
     if (!freed)
@@ -42,12 +52,21 @@ arena::~arena()
 #endif // PALLOC_DEBUG
 }
 
-arena::arena(arena&& other) noexcept : memory(other.memory), used(other.used.load()), capacity(other.capacity)
+arena::arena(arena&& other) noexcept
+    : generation(next_generation.fetch_add(1, std::memory_order_relaxed)), chunk_size(other.chunk_size.load()),
+      destructors(other.destructors.exchange(nullptr)), memory(other.memory),
+      used(other.used.load()), top(other.top.load()), capacity(other.capacity), sizing(other.sizing), mapped(other.mapped),
+      retained_bytes(other.retained_bytes), decay_percent(other.decay_percent),
+      high_water(other.high_water), cycle_peak(other.cycle_peak), touched(other.touched)
 {
-    other.reset();
+    // detach the memory first, so other's reset() cannot purge pages that are ours now
+    other.memory = nullptr;
     other.capacity = 0;
+    other.mapped = 0;
+    other.reset();
     other.used = 0;
-    other.memory = nullptr;
+    other.top = 0;
+    other.touched = 0;
 }
 
 arena& arena::operator=(arena&& other) noexcept
@@ -57,26 +76,66 @@ arena& arena::operator=(arena&& other) noexcept
 
     if (memory != nullptr)
     {
-        AL::platform_mem::free(memory, capacity);
+        run_destructors(memory);
+        AL::platform_mem::free(memory, mapped);
     }
 
+    // chunks threads hold in either arena are now stale
+    generation.store(next_generation.fetch_add(1, std::memory_order_relaxed), std::memory_order_relaxed);
+    chunk_size.store(other.chunk_size.load(), std::memory_order_relaxed);
+    destructors.store(other.destructors.exchange(nullptr), std::memory_order_relaxed);
     memory = other.memory;
     used = other.used.load();
+    top = other.top.load();
     capacity = other.capacity;
+    sizing = other.sizing;
+    mapped = other.mapped;
+    retained_bytes = other.retained_bytes;
+    decay_percent = other.decay_percent;
+    high_water = other.high_water;
+    cycle_peak = other.cycle_peak;
+    touched = other.touched;
 
-    other.reset();
+    other.memory = nullptr;
     other.capacity = 0;
+    other.mapped = 0;
+    other.reset();
     other.used = 0;
-    other.memory = nullptr;
+    other.top = 0;
+    other.touched = 0;
     return *this;
 }
 
-void* arena::alloc(size_t length)
+void* arena::alloc(size_t length, size_t alignment)
 {
-    if (length == 0 || memory == nullptr)
+    if (length == 0 || memory == nullptr || !std::has_single_bit(alignment))
         return nullptr;
 
-    constexpr size_t alignment = alignof(std::max_align_t);
+    const size_t chunk_bytes = chunk_size.load(std::memory_order_relaxed);
+    void* ptr = chunk_bytes != 0 && length <= chunk_bytes ? alloc_chunked(length, alignment, chunk_bytes) : alloc_shared(length, alignment);
+    if (ptr == nullptr)
+        note_failed(length);
+    return ptr;
+}
+
+void arena::note_failed(size_t length)
+{
+    stat_failed.shared_add();
+    if (sizing.percentile == 0)
+        return;
+
+    // saturating add, so an absurd request cannot wrap the sum
+    size_t current = failed_bytes.load(std::memory_order_relaxed);
+    size_t sum;
+    do
+    {
+        sum = length > static_cast<size_t>(-1) - current ? static_cast<size_t>(-1) : current + length;
+    } while (!failed_bytes.compare_exchange_weak(current, sum, std::memory_order_relaxed));
+}
+
+void* arena::alloc_shared(size_t length, size_t alignment)
+{
+    const uintptr_t base = reinterpret_cast<uintptr_t>(memory);
 
     size_t current;
     size_t aligned;
@@ -84,21 +143,200 @@ void* arena::alloc(size_t length)
     {
         current = used.load(std::memory_order::relaxed);
 
-        // align current offset up to the required alignment boundary
-        aligned = (current + alignment - 1) & ~(alignment - 1);
+        // align the address, not the offset, so alignments above the page size hold as well.
+        // alignment is a power of two, so this is an add and a mask
+        aligned = ((base + current + alignment - 1) & ~(alignment - 1)) - base;
+
+        // if we do not have enough space left below the top end
+        const size_t limit = top.load(std::memory_order_relaxed);
+        if (aligned > limit || length > (limit - aligned))
+            return nullptr;
+
+        if (used.compare_exchange_weak(current, aligned + length, std::memory_order_seq_cst, std::memory_order_relaxed))
+            break;
+    }
+
+    // alloc_top() may have moved down since the check above. each end publishes its own offset before
+    // reading the other's, both seq_cst, so at least one of two racing allocations sees the overlap
+    const size_t end = aligned + length;
+    if (end <= top.load(std::memory_order_seq_cst))
+        return memory + aligned;
+
+    // give the range back if nobody allocated behind it
+    size_t expected = end;
+    used.compare_exchange_strong(expected, current, std::memory_order_relaxed);
+    return nullptr;
+}
+
+void* arena::alloc_top(size_t length, size_t alignment)
+{
+    if (length == 0 || memory == nullptr || !std::has_single_bit(alignment))
+        return nullptr;
+
+    const uintptr_t base = reinterpret_cast<uintptr_t>(memory);
+
+    size_t current = top.load(std::memory_order_relaxed);
+    size_t start;
+    while (true)
+    {
+        // align the address down. the result may fall below the mapping for large alignments
+        const uintptr_t address = length > current ? 0 : (base + current - length) & ~(alignment - 1);
+        if (address < base + used.load(std::memory_order_relaxed))
+        {
+            note_failed(length);
+            return nullptr;
+        }
+
+        start = address - base;
+        if (top.compare_exchange_weak(current, start, std::memory_order_seq_cst, std::memory_order_relaxed))
+            break;
+    }
+
+    // same handshake as alloc_shared(), from the other side
+    if (used.load(std::memory_order_seq_cst) <= start)
+        return memory + start;
 
-        // if we do not have enough space left in the arena
-        if (length > (capacity - aligned))
+    size_t expected = start;
+    top.compare_exchange_strong(expected, current, std::memory_order_relaxed);
+    note_failed(length);
+    return nullptr;
+}
+
+void* arena::calloc_top(size_t length, size_t alignment)
+{
+    void* ptr = alloc_top(length, alignment);
+
+    if (ptr != nullptr)
+    {
+        std::memset(ptr, 0, length);
+    }
+
+    return ptr;
+}
+
+void arena::reset_top()
+{
+    // the top end's pages stay resident until reset() purges them
+    if (top.load(std::memory_order_relaxed) != capacity)
+        touched = capacity;
+    top.store(capacity, std::memory_order_relaxed);
+}
+
+size_t arena::get_used_top() const
+{
+    return capacity - top.load(std::memory_order_relaxed);
+}
+
+void* arena::alloc_chunked(size_t length, size_t alignment, size_t chunk_bytes)
+{
+    const uint64_t current_generation = generation.load(std::memory_order_relaxed);
+
+    // bumps the chunk's cursor. returns: nullptr if length does not fit behind the aligned cursor
+    auto bump = [length, alignment](thread_chunk& c) -> std::byte* {
+        const size_t padding = (0 - reinterpret_cast<uintptr_t>(c.cursor)) & (alignment - 1);
+        if (padding > static_cast<size_t>(c.end - c.cursor) || length > static_cast<size_t>(c.end - c.cursor) - padding)
             return nullptr;
+        std::byte* p = c.cursor + padding;
+        c.cursor = p + length;
+        return p;
+    };
 
-        if (used.compare_exchange_weak(current, aligned + length, std::memory_order_release, std::memory_order_relaxed))
-            return memory + aligned;
+    thread_chunk& chunk = local_chunk();
+    if (chunk.owner == this && chunk.generation == current_generation)
+    {
+        if (std::byte* p = bump(chunk))
+            return p;
+    }
+
+    // one CAS on the shared offset per chunk. near the end of the arena a full chunk may no longer fit,
+    // then only this allocation is taken so the tail stays usable
+    stat_chunk_refills.shared_add();
+    std::byte* start = static_cast<std::byte*>(alloc_shared(chunk_bytes, default_alignment));
+    if (start == nullptr)
+        return alloc_shared(length, alignment);
+
+    chunk = {this, current_generation, start, start + chunk_bytes};
+    if (std::byte* p = bump(chunk))
+        return p;
+
+    // the alignment padding did not fit in a fresh chunk
+    return alloc_shared(length, alignment);
+}
+
+bool arena::try_extend(void* ptr, size_t old_len, size_t new_len)
+{
+    const uintptr_t address = reinterpret_cast<uintptr_t>(ptr);
+    const uintptr_t base = reinterpret_cast<uintptr_t>(memory);
+    if (ptr == nullptr || memory == nullptr || address < base || address - base > capacity || old_len > capacity - (address - base))
+        return false;
+
+    const size_t start = address - base;
+    const size_t old_end = start + old_len;
+
+    // the calling thread's chunk, bumped without atomics
+    if (chunk_size.load(std::memory_order_relaxed) != 0)
+    {
+        thread_chunk& chunk = local_chunk();
+        if (chunk.owner == this && chunk.generation == generation.load(std::memory_order_relaxed) && chunk.cursor == memory + old_end)
+        {
+            if (new_len > old_len && new_len - old_len > static_cast<size_t>(chunk.end - chunk.cursor))
+                return false;
+
+            chunk.cursor = memory + start + new_len;
+            if (new_len > old_len)
+                stat_extends.shared_add();
+            return true;
+        }
+    }
+
+    if (new_len <= old_len)
+    {
+        // hand the tail back if nothing was allocated behind ptr
+        size_t expected = old_end;
+        used.compare_exchange_strong(expected, start + new_len, std::memory_order_relaxed);
+        return true;
+    }
+
+    const size_t limit = top.load(std::memory_order_relaxed);
+    if (old_end > limit || new_len - old_len > limit - old_end)
+        return false;
+
+    // fails if ptr is no longer the most recent allocation
+    const size_t new_end = start + new_len;
+    size_t expected = old_end;
+    if (!used.compare_exchange_strong(expected, new_end, std::memory_order_seq_cst, std::memory_order_relaxed))
+        return false;
+
+    // same handshake with alloc_top() as alloc_shared()
+    if (new_end <= top.load(std::memory_order_seq_cst))
+    {
+        stat_extends.shared_add();
+        return true;
     }
+
+    expected = new_end;
+    used.compare_exchange_strong(expected, old_end, std::memory_order_relaxed);
+    return false;
+}
+
+void* arena::realloc(void* ptr, size_t old_len, size_t new_len, size_t alignment)
+{
+    if (ptr == nullptr)
+        return alloc(new_len, alignment);
+    if (new_len == 0)
+        return nullptr;
+    if (try_extend(ptr, old_len, new_len))
+        return ptr;
+
+    void* moved = alloc(new_len, alignment);
+    if (moved != nullptr)
+        std::memcpy(moved, ptr, std::min(old_len, new_len));
+    return moved;
 }
 
-void* arena::calloc(size_t length)
+void* arena::calloc(size_t length, size_t alignment)
 {
-    void* ptr = alloc(length);
+    void* ptr = alloc(length, alignment);
 
     if (ptr != nullptr)
     {
@@ -108,9 +346,213 @@ void* arena::calloc(size_t length)
     return ptr;
 }
 
+void* arena::alloc_object(size_t bytes, size_t alignment, destroy_fn destroy, size_t count)
+{
+    if (destroy == nullptr)
+        return alloc(bytes, alignment);
+
+    // one allocation: the node first, then the objects at their own alignment
+    const size_t node_alignment = std::max(alignment, alignof(destructor_node));
+    const size_t offset = destructor_node::object_offset(node_alignment);
+    if (bytes > static_cast<size_t>(-1) - offset)
+        return nullptr;
+
+    auto* node = static_cast<destructor_node*>(alloc(offset + bytes, node_alignment));
+    if (node == nullptr)
+        return nullptr;
+
+    node->next = nullptr;
+    node->destroy = destroy;
+    node->objects = reinterpret_cast<std::byte*>(node) + offset;
+    node->count = count;
+    return node->objects;
+}
+
+void arena::commit_object(void* ptr, size_t alignment)
+{
+    const size_t offset = destructor_node::object_offset(std::max(alignment, alignof(destructor_node)));
+    auto* node = reinterpret_cast<destructor_node*>(static_cast<std::byte*>(ptr) - offset);
+
+    node->next = destructors.load(std::memory_order_relaxed);
+    while (!destructors.compare_exchange_weak(node->next, node, std::memory_order_release, std::memory_order_relaxed))
+        ;
+}
+
+void arena::run_destructors(const std::byte* boundary)
+{
+    destructor_node* node = destructors.load(std::memory_order_acquire);
+    if (node == nullptr)
+        return;
+
+    // the list is newest first, so objects are destroyed in reverse order of construction.
+    // with thread chunks the list is not sorted by address, so every node is checked
+    destructor_node* kept = nullptr;
+    destructor_node** tail = &kept;
+    while (node != nullptr)
+    {
+        destructor_node* next = node->next;
+        if (reinterpret_cast<const std::byte*>(node) >= boundary)
+        {
+            node->destroy(node->objects, node->count);
+        }
+        else
+        {
+            *tail = node;
+            tail = &node->next;
+        }
+        node = next;
+    }
+    *tail = nullptr;
+    destructors.store(kept, std::memory_order_relaxed);
+}
+
+void arena::set_thread_chunk_size(size_t bytes)
+{
+    constexpr size_t alignment = alignof(std::max_align_t);
+    chunk_size.store((bytes + alignment - 1) & ~(alignment - 1), std::memory_order_relaxed);
+}
+
 int arena::reset()
 {
+    run_destructors(memory);
+
+    // retires every thread's chunk
+    generation.store(next_generation.fetch_add(1, std::memory_order_relaxed), std::memory_order_relaxed);
+    const size_t peak = std::max(cycle_peak, used.load(std::memory_order_relaxed));
+    // what the cycle would have needed for every request to fit
+    const size_t in_use = peak + get_used_top();
+    const size_t failed = failed_bytes.exchange(0, std::memory_order_relaxed);
+    const size_t demand = failed > static_cast<size_t>(-1) - in_use ? static_cast<size_t>(-1) : in_use + failed;
     used = 0;
+    cycle_peak = 0;
+    stat_resets.add();
+
+    // pages of the top end lie just below capacity, so the shrink and purge below have to cover it
+    if (top.load(std::memory_order_relaxed) != capacity)
+        touched = capacity;
+
+    // a resize may move memory, every chunk was retired above
+    const int resized = sizing.percentile != 0 ? resize_to_demand(demand) : 0;
+    top = capacity;
+    const int released = release_above(std::min(peak, capacity));
+    return resized == 0 && released == 0 ? 0 : -1;
+}
+
+int arena::resize_to_demand(size_t demand)
+{
+    if (memory == nullptr)
+        return 0;
+
+    sizing.peaks[sizing.next] = demand;
+    sizing.next = (sizing.next + 1) % sizing.window;
+    sizing.count = std::min(sizing.count + 1, sizing.window);
+
+    // nearest rank percentile of the window
+    std::array<size_t, max_size_window> sorted = sizing.peaks;
+    std::sort(sorted.begin(), sorted.begin() + sizing.count);
+    const size_t rank = (sizing.count * sizing.percentile + 99) / 100;
+    const size_t wanted = sorted[std::max<size_t>(rank, 1) - 1];
+
+    const size_t page_size = AL::platform_mem::page_size();
+    if (wanted > static_cast<size_t>(-1) - page_size)
+        return -1;
+    const size_t target = std::max(((wanted + page_size - 1) / page_size) * page_size, page_size);
+    if (target == capacity)
+        return 0;
+
+    if (target > mapped)
+    {
+        void* ptr = AL::platform_mem::resize(memory, mapped, target);
+        if (ptr == nullptr)
+            return -1;
+        memory = static_cast<std::byte*>(ptr);
+        mapped = target;
+    }
+    else if (target < capacity)
+    {
+        // decommit above the new capacity, the range stays mapped so growing back needs no remap
+        const size_t end = std::min(((touched + page_size - 1) / page_size) * page_size, capacity);
+        if (end > target)
+        {
+            stat_purged_bytes.add(end - target);
+            if (!AL::platform_mem::purge(memory + target, end - target))
+                return -1;
+        }
+        touched = std::min(touched, target);
+    }
+
+    capacity = target;
+    stat_resizes.add();
+    return 0;
+}
+
+void arena::set_auto_size(unsigned percentile, size_t window)
+{
+    sizing = {};
+    sizing.percentile = std::min(percentile, 100u);
+    sizing.window = std::clamp<size_t>(window, 1, max_size_window);
+}
+
+int arena::release_above(size_t peak)
+{
+    touched = std::max(touched, peak);
+
+    size_t keep = retained_bytes;
+    if (decay_percent != 0)
+    {
+        // high_water * (100 - decay) / 100 without overflowing
+        const size_t kept_percent = 100 - decay_percent;
+        const size_t decayed = high_water / 100 * kept_percent + high_water % 100 * kept_percent / 100;
+        high_water = std::max(peak, decayed);
+        keep = std::min(keep, high_water);
+    }
+
+    const size_t page_size = AL::platform_mem::page_size();
+    const size_t end = ((touched + page_size - 1) / page_size) * page_size;
+    keep = keep >= end ? end : ((keep + page_size - 1) / page_size) * page_size;
+    if (memory == nullptr || keep >= end)
+        return 0;
+
+    touched = keep;
+    stat_purged_bytes.add(end - keep);
+    return AL::platform_mem::purge(memory + keep, end - keep) ? 0 : -1;
+}
+
+void arena::set_retained_bytes(size_t bytes)
+{
+    retained_bytes = bytes;
+}
+
+void arena::set_high_water_decay(unsigned percent)
+{
+    decay_percent = std::min(percent, 100u);
+}
+
+size_t arena::get_resident() const
+{
+    if (memory == nullptr)
+        return 0;
+    return AL::platform_mem::resident(memory, mapped);
+}
+
+arena::marker arena::mark() const
+{
+    return {used.load(std::memory_order_relaxed)};
+}
+
+int arena::rollback(marker m)
+{
+    if (m.offset > used.load(std::memory_order_relaxed))
+        return -1;
+
+    run_destructors(memory + m.offset);
+
+    // chunks may reach past m, so none of them can be bumped again
+    if (chunk_size.load(std::memory_order_relaxed) != 0)
+        generation.store(next_generation.fetch_add(1, std::memory_order_relaxed), std::memory_order_relaxed);
+    cycle_peak = std::max(cycle_peak, used.load(std::memory_order_relaxed));
+    used.store(m.offset, std::memory_order_relaxed);
+    stat_rollbacks.add();
     return 0;
 }
 
@@ -118,7 +560,8 @@ int arena::clear()
 {
     if (memory != nullptr)
     {
-        bool ok = AL::platform_mem::free(memory, capacity);
+        run_destructors(memory);
+        bool ok = AL::platform_mem::free(memory, mapped);
         memory = nullptr;
 
         if (!ok)
@@ -126,7 +569,12 @@ int arena::clear()
     }
 
     used.store(0);
+    top.store(0);
     capacity = 0;
+    mapped = 0;
+    touched = 0;
+    cycle_peak = 0;
+    high_water = 0;
     return 0;
 }
 
@@ -139,4 +587,20 @@ size_t arena::get_capacity() const
 {
     return capacity;
 }
+
+arena_stats arena::stats() const
+{
+    arena_stats s;
+    s.used = used.load(std::memory_order_relaxed);
+    s.capacity = capacity;
+    s.failed_allocs = stat_failed.get();
+    s.resets = stat_resets.get();
+    s.chunk_refills = stat_chunk_refills.get();
+    s.rollbacks = stat_rollbacks.get();
+    s.purged_bytes = stat_purged_bytes.get();
+    s.used_top = get_used_top();
+    s.in_place_extends = stat_extends.get();
+    s.resizes = stat_resizes.get();
+    return s;
+}
 } // namespace AL
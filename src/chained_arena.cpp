@@ -0,0 +1,278 @@
+#include "chained_arena.h"
+#include "platform.h"
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <new>
+
+namespace AL
+{
+namespace
+{
+size_t round_to_pages(size_t bytes)
+{
+    const size_t page_size = AL::platform_mem::page_size();
+    return ((bytes + page_size - 1) / page_size) * page_size;
+}
+
+// bytes * factor, saturating at limit
+size_t grow_size(size_t bytes, size_t factor, size_t limit)
+{
+    return bytes > limit / factor ? limit : bytes * factor;
+}
+} // namespace
+
+chained_arena::chained_arena(size_t bytes, const chained_arena_growth& growth)
+    : current(nullptr), oversized(nullptr), block_count(0), next_block_bytes(0), first_block_bytes(round_to_pages(std::max<size_t>(bytes, 1))),
+      growth_factor(std::max<size_t>(growth.factor, 1)), max_block_bytes(std::max(growth.max_block_bytes, first_block_bytes))
+{
+    block* b = map_block(first_block_bytes - header_size(), nullptr);
+    if (b == nullptr)
+        throw std::bad_alloc();
+
+    current.store(b, std::memory_order_relaxed);
+    block_count.store(1, std::memory_order_relaxed);
+    next_block_bytes = grow_size(b->mapped, growth_factor, max_block_bytes);
+}
+
+chained_arena::~chained_arena()
+{
+    bool ok = clear() == 0;
+
+#if PALLOC_DEBUG
+    if (!ok)
+    {
+        std::cerr << "WARNING: munmap failed in chained_arena destructor\n";
+    }
+#else
+    (void)ok;
+#endif // PALLOC_DEBUG
+}
+
+chained_arena::block* chained_arena::map_block(size_t bytes, block* prev)
+{
+    if (bytes > std::numeric_limits<size_t>::max() - header_size() - AL::platform_mem::page_size())
+        return nullptr;
+
+    const size_t mapped = round_to_pages(header_size() + bytes);
+    void* mem = AL::platform_mem::alloc(mapped);
+    if (mem == nullptr)
+        return nullptr;
+
+    block* b = std::construct_at(static_cast<block*>(mem));
+    b->prev = prev;
+    b->mapped = mapped;
+    b->capacity = mapped - header_size();
+    b->used.store(0, std::memory_order_relaxed);
+    return b;
+}
+
+bool chained_arena::unmap_block(block* b)
+{
+    const size_t mapped = b->mapped;
+    std::destroy_at(b);
+    return AL::platform_mem::free(b, mapped);
+}
+
+bool chained_arena::unmap_chain(block* b)
+{
+    bool ok = true;
+    while (b)
+    {
+        block* prev = b->prev;
+        if (!unmap_block(b))
+            ok = false;
+        b = prev;
+    }
+    return ok;
+}
+
+void* chained_arena::try_alloc(block& b, size_t length, size_t alignment)
+{
+    const uintptr_t base = reinterpret_cast<uintptr_t>(b.data());
+
+    size_t current_used = b.used.load(std::memory_order_relaxed);
+    while (true)
+    {
+        // align the address, see arena::alloc_shared()
+        const size_t aligned = ((base + current_used + alignment - 1) & ~(alignment - 1)) - base;
+        if (aligned > b.capacity || length > b.capacity - aligned)
+            return nullptr;
+
+        if (b.used.compare_exchange_weak(current_used, aligned + length, std::memory_order_release, std::memory_order_relaxed))
+            return b.data() + aligned;
+    }
+}
+
+void* chained_arena::alloc(size_t length, size_t alignment)
+{
+    if (length == 0 || !std::has_single_bit(alignment))
+        return nullptr;
+
+    // O(1) fast path: bump the current block
+    if (block* b = current.load(std::memory_order_acquire))
+    {
+        if (void* p = try_alloc(*b, length, alignment))
+            return p;
+    }
+
+    return alloc_slow(length, alignment);
+}
+
+void* chained_arena::alloc_slow(size_t length, size_t alignment)
+{
+    std::lock_guard<std::mutex> lock(grow_mutex);
+
+    // another thread may have linked a block while we waited
+    block* head = current.load(std::memory_order_relaxed);
+    if (head)
+    {
+        if (void* p = try_alloc(*head, length, alignment))
+            return p;
+    }
+
+    // data() is only aligned to default_alignment
+    const size_t padding = alignment > default_alignment ? alignment - default_alignment : 0;
+    if (length > std::numeric_limits<size_t>::max() - padding)
+    {
+        stat_failed.shared_add();
+        return nullptr;
+    }
+
+    // an allocation larger than the growth schedule gets a block of its own size. it is set aside,
+    // so head keeps serving the allocations that fit and reset() does not keep the outlier
+    const size_t scheduled = head ? next_block_bytes : first_block_bytes;
+    if (length + padding > scheduled - header_size())
+    {
+        block* b = map_block(length + padding, oversized.load(std::memory_order_relaxed));
+        if (b == nullptr)
+        {
+            stat_failed.shared_add();
+            return nullptr;
+        }
+
+        void* p = try_alloc(*b, length, alignment);
+        oversized.store(b, std::memory_order_release);
+        block_count.fetch_add(1, std::memory_order_relaxed);
+        if (head)
+            stat_grows.add();
+        return p;
+    }
+
+    // the space left in head is abandoned
+    block* b = map_block(scheduled - header_size(), head);
+    if (b == nullptr)
+    {
+        stat_failed.shared_add();
+        return nullptr;
+    }
+
+    // nobody else can see b yet, so this cannot fail or contend
+    void* p = try_alloc(*b, length, alignment);
+    current.store(b, std::memory_order_release);
+    block_count.fetch_add(1, std::memory_order_relaxed);
+    next_block_bytes = grow_size(scheduled, growth_factor, max_block_bytes);
+    if (head)
+        stat_grows.add();
+    return p;
+}
+
+void* chained_arena::calloc(size_t length, size_t alignment)
+{
+    void* ptr = alloc(length, alignment);
+
+    if (ptr != nullptr)
+    {
+        std::memset(ptr, 0, length);
+    }
+
+    return ptr;
+}
+
+int chained_arena::reset()
+{
+    block* largest = nullptr;
+    for (block* b = current.load(std::memory_order_relaxed); b; b = b->prev)
+    {
+        if (!largest || b->mapped > largest->mapped)
+            largest = b;
+    }
+
+    int result = unmap_chain(oversized.load(std::memory_order_relaxed)) ? 0 : -1;
+    oversized.store(nullptr, std::memory_order_relaxed);
+
+    block* b = current.load(std::memory_order_relaxed);
+    while (b)
+    {
+        block* prev = b->prev;
+        if (b != largest && !unmap_block(b))
+            result = -1;
+        b = prev;
+    }
+
+    if (largest)
+    {
+        largest->prev = nullptr;
+        largest->used.store(0, std::memory_order_relaxed);
+        next_block_bytes = grow_size(largest->mapped, growth_factor, max_block_bytes);
+    }
+    block_count.store(largest ? 1 : 0, std::memory_order_relaxed);
+    current.store(largest, std::memory_order_relaxed);
+    stat_resets.add();
+    return result;
+}
+
+int chained_arena::clear()
+{
+    int result = unmap_chain(current.load(std::memory_order_relaxed)) ? 0 : -1;
+    if (!unmap_chain(oversized.load(std::memory_order_relaxed)))
+        result = -1;
+
+    current.store(nullptr, std::memory_order_relaxed);
+    oversized.store(nullptr, std::memory_order_relaxed);
+    block_count.store(0, std::memory_order_relaxed);
+    return result;
+}
+
+size_t chained_arena::get_used() const
+{
+    size_t total = 0;
+    for (block* b = current.load(std::memory_order_acquire); b; b = b->prev)
+        total += b->used.load(std::memory_order_relaxed);
+    for (block* b = oversized.load(std::memory_order_acquire); b; b = b->prev)
+        total += b->used.load(std::memory_order_relaxed);
+    return total;
+}
+
+size_t chained_arena::get_capacity() const
+{
+    size_t total = 0;
+    for (block* b = current.load(std::memory_order_acquire); b; b = b->prev)
+        total += b->capacity;
+    for (block* b = oversized.load(std::memory_order_acquire); b; b = b->prev)
+        total += b->capacity;
+    return total;
+}
+
+size_t chained_arena::get_block_count() const
+{
+    return block_count.load(std::memory_order_relaxed);
+}
+
+chained_arena_stats chained_arena::stats() const
+{
+    chained_arena_stats s;
+    s.used = get_used();
+    s.capacity = get_capacity();
+    s.blocks = get_block_count();
+    s.grows = stat_grows.get();
+    s.failed_allocs = stat_failed.get();
+    s.resets = stat_resets.get();
+    return s;
+}
+} // namespace AL
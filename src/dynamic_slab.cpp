@@ -1,51 +1,369 @@
 #include "dynamic_slab.h"
+#include "epoch_domain.h"
 #include "platform.h"
+#include "profiler.h"
+#include <algorithm>
 #include <cstddef>
 #include <cstring>
 #include <memory>
+#include <thread>
 
 namespace AL
 {
 
+thread_local std::array<dynamic_slab::cache_entry, dynamic_slab::max_cached_instances> dynamic_slab::caches = {};
+
+namespace
+{
+std::atomic<size_t> next_thread_ordinal{0};
+
+// round robin position of the calling thread, shared by every dynamic_slab
+size_t thread_ordinal()
+{
+    thread_local const size_t ordinal = next_thread_ordinal.fetch_add(1, std::memory_order_relaxed);
+    return ordinal;
+}
+} // namespace
+
+// one per thread that has ever claimed a cache entry, see slab::thread_registration
+struct dynamic_slab::thread_registration
+{
+    // held by this thread while it evicts or exits, and by a dynamic_slab that drops one of its entries
+    std::mutex mutex;
+
+    thread_registration()
+    {
+        // registers this thread with epoch_domain first, so its record is destroyed after this one.
+        // flushing on exit pins the epoch
+        epoch_domain::guard guard;
+    }
+
+    ~thread_registration()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        // owners are alive here: ~dynamic_slab() needs this lock to drop the entries it still owns
+        for (cache_entry& entry : caches)
+        {
+            if (dynamic_slab* owner = entry.owner.load(std::memory_order_relaxed))
+                owner->detach(entry);
+        }
+    }
+};
+
+dynamic_slab::thread_registration& dynamic_slab::register_thread()
+{
+    thread_local thread_registration registration;
+    return registration;
+}
+
+dynamic_slab::cache_entry& dynamic_slab::get_cache()
+{
+    for (cache_entry& entry : caches)
+        if (entry.owner.load(std::memory_order_relaxed) == this)
+            return entry;
+
+    // acquire pairs with the release store in ~dynamic_slab() when another thread emptied a slot
+    for (cache_entry& entry : caches)
+    {
+        if (entry.owner.load(std::memory_order_acquire) == nullptr)
+        {
+            attach(entry, register_thread());
+            return entry;
+        }
+    }
+
+    // every slot belongs to another dynamic_slab. evict the last one, like slab does
+    stat_evictions.shared_add();
+    cache_entry& entry = caches[max_cached_instances - 1];
+    thread_registration& thread = register_thread();
+    std::lock_guard<std::mutex> lock(thread.mutex);
+    // the thread lock keeps the old owner from finishing its destructor under us
+    entry.owner.load(std::memory_order_relaxed)->detach(entry);
+    attach(entry, thread);
+    return entry;
+}
+
+void dynamic_slab::attach(cache_entry& entry, thread_registration& thread)
+{
+    for (size_t i = 0; i < NUM_SIZE_CLASSES; i++)
+    {
+        entry.storage[i].invalidate();
+        entry.storage[i].batch_size = slab::index_to_batch_size(i);
+        entry.hints[i] = {};
+    }
+
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    entry.thread = &thread;
+    entry.registry_prev = nullptr;
+    entry.registry_next = registered;
+    if (registered)
+        registered->registry_prev = &entry;
+    registered = &entry;
+    entry.owner.store(this, std::memory_order_relaxed);
+}
+
+void dynamic_slab::detach(cache_entry& entry)
+{
+    flush_entry(entry);
+
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    for (size_t i = 0; i < NUM_SIZE_CLASSES; i++)
+    {
+        retired_counters[i].absorb(entry.storage[i].counters);
+        entry.storage[i].counters.clear();
+    }
+
+    if (entry.registry_prev)
+        entry.registry_prev->registry_next = entry.registry_next;
+    else
+        registered = entry.registry_next;
+    if (entry.registry_next)
+        entry.registry_next->registry_prev = entry.registry_prev;
+    entry.registry_prev = nullptr;
+    entry.registry_next = nullptr;
+    entry.owner.store(nullptr, std::memory_order_relaxed);
+}
+
+void dynamic_slab::flush_entry(cache_entry& entry)
+{
+    for (size_t i = 0; i < NUM_SIZE_CLASSES; i++)
+    {
+        thread_local_cache& cache = entry.storage[i];
+        if (cache.is_empty())
+            continue;
+        flush(i, cache.current, cache.objects.data());
+        cache.counters.on_flush();
+        cache.invalidate();
+    }
+}
+
 dynamic_slab::slab_node* dynamic_slab::create_node(slab_node* next_ptr)
 {
     void* mem = AL::platform_mem::alloc(sizeof(slab_node));
     if (mem == nullptr)
         return nullptr;
 
+    slab_node* node;
     try
     {
         // uses placement new. initializes the object at the given address 'mem'.
         // this acts as a constructor call on existing memory and does NOT allocate new memory.
-        return std::construct_at(static_cast<slab_node*>(mem), scale, next_ptr);
+        node = std::construct_at(static_cast<slab_node*>(mem), next_scale, next_ptr);
     }
     catch (...)
     {
         AL::platform_mem::free(mem, sizeof(slab_node));
         return nullptr;
     }
+
+    // counted before the pages are mapped, so destroy_node() can undo a partial insert below
+    mapped_bytes.fetch_add(node_bytes(*node), std::memory_order_relaxed);
+
+    // map the pages before the caller publishes the node as head. a block can only reach free()
+    // after palloc() returned it, so every lookup sees the finished entries
+    for (size_t i = 0; i < node->value.get_pool_count(); i++)
+    {
+        if (!owners.insert(node->value.get_pool_memory_start(i), node->value.get_pool_memory_end(i), node))
+        {
+            destroy_node(node);
+            return nullptr;
+        }
+    }
+
+    // only advance once the node exists, so a failed grow retries at the same size.
+    // a scale below 1 truncates to 0, which growth would never leave, so it grows from 1
+    if (growth_factor > 1)
+    {
+        const size_t scale = std::max<size_t>(next_scale, 1);
+        next_scale = scale > max_scale / growth_factor ? max_scale : scale * growth_factor;
+    }
+    return node;
+}
+
+void dynamic_slab::destroy_node(slab_node* node)
+{
+    for (size_t i = 0; i < node->value.get_pool_count(); i++)
+        owners.erase(node->value.get_pool_memory_start(i), node->value.get_pool_memory_end(i));
+
+    mapped_bytes.fetch_sub(node_bytes(*node), std::memory_order_relaxed);
+    node->~slab_node();
+    AL::platform_mem::free(node, sizeof(slab_node));
+}
+
+namespace
+{
+// platform_mem maps whole pages
+size_t round_to_pages(size_t bytes)
+{
+    const size_t page_size = AL::platform_mem::page_size();
+    return ((bytes + page_size - 1) / page_size) * page_size;
+}
+} // namespace
+
+size_t dynamic_slab::node_bytes(const slab_node& node)
+{
+    return round_to_pages(sizeof(slab_node)) + node.value.get_total_capacity();
+}
+
+size_t dynamic_slab::node_bytes(size_t scale)
+{
+    return round_to_pages(sizeof(slab_node)) + slab::capacity_for_scale(scale);
+}
+
+bool dynamic_slab::next_node_exceeds(const std::atomic<size_t>& limit) const
+{
+    const size_t bytes = limit.load(std::memory_order_relaxed);
+    return bytes != 0 && mapped_bytes.load(std::memory_order_relaxed) + node_bytes(next_scale) > bytes;
+}
+
+dynamic_slab::slab_node* dynamic_slab::grow_locked()
+{
+    // a retired node that is still mapped can go straight back into the list.
+    // readers that still hold it are unaffected, it never stopped being valid memory
+    if (retired)
+    {
+        slab_node* node = retired;
+        retired = node->retired_next;
+        node->retired_next = nullptr;
+        node->seen_empty = false;
+        return node;
+    }
+
+    // fail fast, a leak should surface as nullptr rather than as the OOM killer
+    if (next_node_exceeds(hard_limit))
+    {
+        stat_hard_limit_failures.add();
+        return nullptr;
+    }
+
+    return create_node(head.load(std::memory_order_relaxed));
+}
+
+void dynamic_slab::publish_locked(slab_node* node)
+{
+    node->next.store(head.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    node->linked.store(true, std::memory_order_relaxed);
+    head.store(node, std::memory_order_release);
+    node_count.fetch_add(1, std::memory_order_relaxed);
+
+    for (size_t i = 0; i < NUM_SIZE_CLASSES; i++)
+        list_available(node, i);
+}
+
+void dynamic_slab::list_available(slab_node* node, size_t index)
+{
+    available_list& list = available[index];
+    std::lock_guard<std::mutex> lock(list.mutex);
+    if (node->listed[index].load(std::memory_order_relaxed) || !node->linked.load(std::memory_order_relaxed))
+        return;
+
+    node->avail_next[index] = list.head.load(std::memory_order_relaxed);
+    node->listed[index].store(true, std::memory_order_relaxed);
+    list.head.store(node, std::memory_order_release);
+}
+
+void dynamic_slab::unlist_if_top(slab_node* node, size_t index)
+{
+    available_list& list = available[index];
+    std::lock_guard<std::mutex> lock(list.mutex);
+    if (list.head.load(std::memory_order_relaxed) != node)
+        return;
+
+    list.head.store(node->avail_next[index], std::memory_order_release);
+    node->avail_next[index] = nullptr;
+    node->listed[index].store(false, std::memory_order_relaxed);
 }
 
-dynamic_slab::dynamic_slab(size_t s) : scale(s), head(nullptr), node_count(0)
+void dynamic_slab::unlist_all_locked(slab_node* node)
 {
-    slab_node* node = create_node(nullptr);
-    if (node)
+    // every list_available() that runs after the class mutex below has been taken sees this
+    node->linked.store(false, std::memory_order_relaxed);
+
+    for (size_t i = 0; i < NUM_SIZE_CLASSES; i++)
+    {
+        available_list& list = available[i];
+        std::lock_guard<std::mutex> lock(list.mutex);
+        if (!node->listed[i].load(std::memory_order_relaxed))
+            continue;
+
+        slab_node* prev = nullptr;
+        for (slab_node* n = list.head.load(std::memory_order_relaxed); n; prev = n, n = n->avail_next[i])
+        {
+            if (n != node)
+                continue;
+            if (prev)
+                prev->avail_next[i] = n->avail_next[i];
+            else
+                list.head.store(n->avail_next[i], std::memory_order_release);
+            break;
+        }
+        node->avail_next[i] = nullptr;
+        node->listed[i].store(false, std::memory_order_relaxed);
+    }
+}
+
+dynamic_slab::dynamic_slab(size_t s, const dynamic_slab_growth& growth)
+    : next_scale(s), growth_factor(std::max<size_t>(growth.factor, 1)), max_scale(std::max(growth.max_scale, s)), head(nullptr), node_count(0),
+      list_version(0), home_count(0), retired(nullptr),
+      retained_empty_nodes(std::max<size_t>(growth.reserve_nodes, 1)), release_delay_ms(1000), mapped_bytes(0), soft_limit(0),
+      hard_limit(0)
+{
+    const size_t reserve = std::max<size_t>(growth.reserve_nodes, 1);
+    for (size_t i = 0; i < reserve; i++)
     {
-        head.store(node, std::memory_order_release);
-        node_count.store(1, std::memory_order_relaxed);
+        slab_node* node = create_node(head.load(std::memory_order_relaxed));
+        if (!node)
+            break;
+        publish_locked(node);
     }
 }
 
 dynamic_slab::~dynamic_slab()
 {
+    // other threads may still be running. each entry is dropped under its thread's lock, so none of
+    // them can be flushing into a node when the release store below hands the slot back.
+    // see slab::for_each_registered_entry()
+    std::unique_lock<std::mutex> lock(registry_mutex);
+    while (cache_entry* entry = registered)
+    {
+        std::unique_lock<std::mutex> thread_lock(entry->thread->mutex, std::try_to_lock);
+        if (!thread_lock.owns_lock())
+        {
+            lock.unlock();
+            std::this_thread::yield();
+            lock.lock();
+            continue;
+        }
+
+        // the blocks die with the nodes
+        for (thread_local_cache& cache : entry->storage)
+        {
+            cache.invalidate();
+            cache.counters.clear();
+        }
+        registered = entry->registry_next;
+        if (registered)
+            registered->registry_prev = nullptr;
+        entry->registry_next = nullptr;
+        entry->owner.store(nullptr, std::memory_order_release);
+    }
+    lock.unlock();
+
     slab_node* current = head.load(std::memory_order_acquire);
     while (current)
     {
-        slab_node* next = current->next;
-        current->~slab_node();
-        AL::platform_mem::free(current, sizeof(slab_node));
+        slab_node* next = current->next.load(std::memory_order_relaxed);
+        destroy_node(current);
         current = next;
     }
+
+    while (retired)
+    {
+        slab_node* next = retired->retired_next;
+        destroy_node(retired);
+        retired = next;
+    }
 }
 
 void* dynamic_slab::palloc(size_t size)
@@ -53,34 +371,126 @@ void* dynamic_slab::palloc(size_t size)
     if (size == 0 || size == static_cast<size_t>(-1))
         return nullptr;
 
-    // lock free traversal
-    // nodes are only prepended, never removed
-    for (slab_node* node = head.load(std::memory_order_acquire); node; node = node->next)
+    const size_t index = slab::size_to_index(size);
+    if (index == static_cast<size_t>(-1))
+        return nullptr;
+
+    cache_entry& entry = get_cache();
+    thread_local_cache& cache = entry.storage[index];
+    if (void* p = cache.try_pop())
     {
-        void* p = node->value.alloc(size);
-        if (p)
-            return p;
+        cache.counters.on_hit();
+        heap_profiler::on_alloc(p, slab::index_to_size_class(index));
+        return p;
     }
 
-    // all slabs exhausted — grow under lock
+    cache.current = refill(entry, index, cache.batch_size, cache.objects.data());
+    cache.counters.on_refill();
+
+    void* p = cache.try_pop();
+    if (p)
+        heap_profiler::on_alloc(p, slab::index_to_size_class(index));
+    return p;
+}
+
+size_t dynamic_slab::refill(cache_entry& entry, size_t index, size_t count, void** out)
+{
+    // a slot whose assignment failed shares the list without locking until the node list changes
+    const size_t slot = home_slot();
+    if (slot != max_home_nodes && !homes[slot].load(std::memory_order_acquire) &&
+        home_failed_at[slot].load(std::memory_order_relaxed) != node_count.load(std::memory_order_relaxed) + 1)
+        assign_home(slot);
+
+    node_hint& hint = entry.hints[index];
+    {
+        // the guard keeps nodes that trim() unlinks under us mapped until we leave
+        epoch_domain::guard guard;
+        const uint64_t version = list_version.load(std::memory_order_acquire);
+
+        // start at home, and after spilling go back as soon as frees have refilled the home pool
+        if (slot != max_home_nodes)
+        {
+            slab_node* home = homes[slot].load(std::memory_order_acquire);
+            const bool hint_valid = hint.node && hint.version == version;
+            if (home && (!hint_valid || (hint.node != home && home->value.get_pool_free_space(index) != 0)))
+                hint = {version, home};
+        }
+
+        // O(1) fast path: the node this thread last refilled this size class from
+        if (hint.node && hint.version == version)
+        {
+            if (size_t n = hint.node->value.alloc_batch(index, count, out))
+                return n;
+        }
+
+        // otherwise take the first node still listed for this size class. nodes that turn out
+        // to be full are popped, so each one is only tried once until a free lists it again.
+        // bounded, because concurrent frees can keep relisting a node whose blocks sit in their caches
+        slab_node* node = available[index].head.load(std::memory_order_acquire);
+        for (size_t attempt = 0; node && attempt < max_listed_attempts; attempt++)
+        {
+            if (size_t n = node->value.alloc_batch(index, count, out))
+            {
+                hint = {version, node};
+                return n;
+            }
+            unlist_if_top(node, index);
+            node = available[index].head.load(std::memory_order_acquire);
+        }
+    }
+
+    // no listed node has room — grow under lock
     std::lock_guard<std::mutex> lock(grow_mutex);
 
-    // double check if another thread may have grown while we waited
-    for (slab_node* node = head.load(std::memory_order_acquire); node; node = node->next)
+    // a concurrent flush may have returned blocks to a node after it was popped from the list,
+    // so try every node whose pool has room once before growing.
+    // nodes are only unmapped under grow_mutex, so no guard is needed here
+    auto alloc_from_list = [&]() -> size_t {
+        const uint64_t version = list_version.load(std::memory_order_relaxed);
+        for (slab_node* node = head.load(std::memory_order_acquire); node; node = node->next.load(std::memory_order_acquire))
+        {
+            if (node->value.get_pool_free_space(index) == 0)
+                continue;
+
+            if (size_t n = node->value.alloc_batch(index, count, out))
+            {
+                list_available(node, index);
+                hint = {version, node};
+                return n;
+            }
+        }
+        return 0;
+    };
+
+    if (size_t n = alloc_from_list())
+        return n;
+
+    // past the soft limit, give back what this thread caches and release empty nodes before mapping
+    // another one. the flushed blocks may be exactly what this size class needs
+    if (!retired && next_node_exceeds(soft_limit))
     {
-        void* p = node->value.alloc(size);
-        if (p)
-            return p;
+        stat_soft_limit_hits.add();
+        flush_entry(entry);
+        trim_locked(false);
+        if (size_t n = alloc_from_list())
+            return n;
     }
 
-    slab_node* new_node = create_node(head.load(std::memory_order_relaxed));
+    const uint64_t version = list_version.load(std::memory_order_relaxed);
+    slab_node* new_node = grow_locked();
     if (!new_node)
-        return nullptr;
+    {
+        stat_grow_failures.add();
+        return 0;
+    }
 
-    head.store(new_node, std::memory_order_release);
-    node_count.fetch_add(1, std::memory_order_relaxed);
+    publish_locked(new_node);
+    stat_grows.add();
 
-    return new_node->value.alloc(size);
+    const size_t n = new_node->value.alloc_batch(index, count, out);
+    if (n)
+        hint = {version, new_node};
+    return n;
 }
 
 void* dynamic_slab::calloc(size_t size)
@@ -100,22 +510,268 @@ void dynamic_slab::free(void* ptr, size_t size)
     if (ptr == nullptr || size == 0 || size == static_cast<size_t>(-1))
         return;
 
-    // lock free traversal
-    // find owning slab, then call its thread-safe free
-    for (slab_node* node = head.load(std::memory_order_acquire); node; node = node->next)
+    const size_t index = slab::size_to_index(size);
+    if (index == static_cast<size_t>(-1))
+        return;
+
+    // O(1) ownership check. the node is not touched, a block that is still allocated keeps it linked
+    if (!owners.find(ptr))
+        return;
+
+    heap_profiler::on_free(ptr);
+
+    thread_local_cache& cache = get_cache().storage[index];
+    if (cache.is_full())
+    {
+        flush(index, cache.batch_size, cache.objects.data() + (cache.current - cache.batch_size));
+        cache.current -= cache.batch_size;
+        cache.counters.on_flush();
+    }
+    cache.push(ptr);
+
+    maybe_trim();
+}
+
+void dynamic_slab::flush(size_t index, size_t count, void** blocks)
+{
+    // a node whose last block comes back may be unlinked right after, keep it mapped until relisted
+    epoch_domain::guard guard;
+
+    // blocks refilled together sit next to each other, so return them in runs per owning node
+    size_t i = 0;
+    while (i < count)
     {
-        if (node->value.owns(ptr))
+        slab_node* node = static_cast<slab_node*>(owners.find(blocks[i]));
+        size_t end = i + 1;
+        while (end < count && owners.find(blocks[end]) == node)
+            end++;
+
+        if (node)
         {
-            node->value.free(ptr, size);
+            node->value.free_batch(index, end - i, blocks + i);
+
+            // a node that was popped as full can allocate again
+            if (!node->listed[index].load(std::memory_order_relaxed))
+                list_available(node, index);
+        }
+        i = end;
+    }
+}
+
+void dynamic_slab::maybe_trim()
+{
+    thread_local size_t frees_until_trim = trim_interval;
+    if (--frees_until_trim != 0)
+        return;
+    frees_until_trim = trim_interval;
+
+    // never stall a free behind a grow or another trim
+    std::unique_lock<std::mutex> lock(grow_mutex, std::try_to_lock);
+    if (lock.owns_lock())
+        trim_locked(true);
+}
+
+size_t dynamic_slab::trim()
+{
+    for (cache_entry& entry : caches)
+    {
+        if (entry.owner.load(std::memory_order_relaxed) == this)
+            flush_entry(entry);
+    }
+
+    std::lock_guard<std::mutex> lock(grow_mutex);
+    return trim_locked(false);
+}
+
+void dynamic_slab::set_retained_empty_nodes(size_t count)
+{
+    retained_empty_nodes.store(count, std::memory_order_relaxed);
+}
+
+void dynamic_slab::set_release_delay(std::chrono::milliseconds delay)
+{
+    release_delay_ms.store(delay.count(), std::memory_order_relaxed);
+}
+
+void dynamic_slab::set_memory_limits(size_t soft_bytes, size_t hard_bytes)
+{
+    soft_limit.store(soft_bytes, std::memory_order_relaxed);
+    hard_limit.store(hard_bytes, std::memory_order_relaxed);
+    // new limits may leave room for the homes that failed under the old ones
+    for (auto& failed : home_failed_at)
+        failed.store(0, std::memory_order_relaxed);
+}
+
+size_t dynamic_slab::get_mapped_bytes() const
+{
+    return mapped_bytes.load(std::memory_order_relaxed);
+}
+
+void dynamic_slab::set_home_nodes(size_t count)
+{
+    home_count.store(std::min(count, max_home_nodes), std::memory_order_relaxed);
+    for (auto& failed : home_failed_at)
+        failed.store(0, std::memory_order_relaxed);
+}
+
+size_t dynamic_slab::home_slot() const
+{
+    const size_t count = home_count.load(std::memory_order_relaxed);
+    if (count == 0)
+        return max_home_nodes;
+    return thread_ordinal() % count;
+}
+
+void dynamic_slab::assign_home(size_t slot)
+{
+    std::lock_guard<std::mutex> lock(grow_mutex);
+    if (homes[slot].load(std::memory_order_relaxed))
+        return;
+
+    auto is_home = [this](const slab_node* node) {
+        for (const auto& home : homes)
+            if (home.load(std::memory_order_relaxed) == node)
+                return true;
+        return false;
+    };
+
+    // prefer the newest node nobody calls home, it is the largest under geometric growth
+    slab_node* node = head.load(std::memory_order_relaxed);
+    while (node && is_home(node))
+        node = node->next.load(std::memory_order_relaxed);
+
+    // past the soft limit a home is not worth a new node, the slot shares the list instead
+    if (!node && !retired && next_node_exceeds(soft_limit))
+    {
+        home_failed_at[slot].store(node_count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        return;
+    }
+
+    if (!node)
+    {
+        node = grow_locked();
+        if (!node)
+        {
+            // threads in this slot share the list like they would without home nodes
+            home_failed_at[slot].store(node_count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            stat_grow_failures.add();
             return;
         }
+        publish_locked(node);
+        stat_grows.add();
+    }
+
+    home_failed_at[slot].store(0, std::memory_order_relaxed);
+    homes[slot].store(node, std::memory_order_release);
+}
+
+size_t dynamic_slab::trim_locked(bool automatic)
+{
+    const size_t keep = retained_empty_nodes.load(std::memory_order_relaxed);
+    const auto now = std::chrono::steady_clock::now();
+    const auto delay = std::chrono::milliseconds(release_delay_ms.load(std::memory_order_relaxed));
+    size_t empty_seen = 0;
+    slab_node* unlinked = nullptr;
+    size_t unlinked_count = 0;
+
+    slab_node* prev = nullptr;
+    slab_node* node = head.load(std::memory_order_relaxed);
+    while (node)
+    {
+        slab_node* next = node->next.load(std::memory_order_relaxed);
+        if (!node->value.is_unused())
+        {
+            node->seen_empty = false;
+            prev = node;
+            node = next;
+            continue;
+        }
+
+        if (!node->seen_empty)
+        {
+            node->seen_empty = true;
+            node->empty_since = now;
+        }
+
+        // keep the empty nodes closest to head, and always at least one node
+        const bool aged = !automatic || now - node->empty_since >= delay;
+        if (empty_seen++ < keep || !aged || node_count.load(std::memory_order_relaxed) == 1)
+        {
+            prev = node;
+            node = next;
+            continue;
+        }
+
+        // readers standing on node still follow its next pointer, which is left intact.
+        // its threads get a new home on their next palloc()
+        for (auto& home : homes)
+            if (home.load(std::memory_order_relaxed) == node)
+                home.store(nullptr, std::memory_order_relaxed);
+        unlist_all_locked(node);
+        if (prev)
+            prev->next.store(next, std::memory_order_release);
+        else
+            head.store(next, std::memory_order_release);
+        node_count.fetch_sub(1, std::memory_order_relaxed);
+
+        node->retired_next = unlinked;
+        unlinked = node;
+        unlinked_count++;
+        node = next;
+    }
+
+    if (unlinked)
+    {
+        list_version.fetch_add(1, std::memory_order_release);
+        const uint64_t retire_epoch = epoch_domain::retire();
+        slab_node* last = unlinked;
+        for (;; last = last->retired_next)
+        {
+            last->retire_epoch = retire_epoch;
+            if (!last->retired_next)
+                break;
+        }
+        last->retired_next = retired;
+        retired = unlinked;
+    }
+
+    reclaim_retired_locked();
+    return unlinked_count;
+}
+
+void dynamic_slab::reclaim_retired_locked()
+{
+    slab_node** link = &retired;
+    while (*link)
+    {
+        slab_node* node = *link;
+        if (!epoch_domain::is_safe(node->retire_epoch))
+        {
+            link = &node->retired_next;
+            continue;
+        }
+        *link = node->retired_next;
+
+        if (node->value.is_unused())
+        {
+            destroy_node(node);
+            stat_releases.add();
+            continue;
+        }
+
+        // a reader that was already inside the node allocated from it before it was unlinked.
+        // it is in use again, so put it back
+        node->retired_next = nullptr;
+        node->seen_empty = false;
+        publish_locked(node);
     }
 }
 
 size_t dynamic_slab::get_total_capacity() const
 {
     size_t total = 0;
-    for (slab_node* node = head.load(std::memory_order_acquire); node; node = node->next)
+    epoch_domain::guard guard;
+    for (slab_node* node = head.load(std::memory_order_acquire); node; node = node->next.load(std::memory_order_acquire))
         total += node->value.get_total_capacity();
     return total;
 }
@@ -123,7 +779,8 @@ size_t dynamic_slab::get_total_capacity() const
 size_t dynamic_slab::get_total_free() const
 {
     size_t total = 0;
-    for (slab_node* node = head.load(std::memory_order_acquire); node; node = node->next)
+    epoch_domain::guard guard;
+    for (slab_node* node = head.load(std::memory_order_acquire); node; node = node->next.load(std::memory_order_acquire))
         total += node->value.get_total_free();
     return total;
 }
@@ -133,4 +790,71 @@ size_t dynamic_slab::get_slab_count() const
     return node_count.load(std::memory_order_relaxed);
 }
 
+dynamic_slab_stats dynamic_slab::stats() const
+{
+    dynamic_slab_stats s;
+    s.node_count = get_slab_count();
+    s.grows = stat_grows.get();
+    s.grow_failures = stat_grow_failures.get();
+    s.releases = stat_releases.get();
+    s.mapped_bytes = get_mapped_bytes();
+    s.soft_limit_hits = stat_soft_limit_hits.get();
+    s.hard_limit_failures = stat_hard_limit_failures.get();
+
+    slab_stats& total = s.slabs;
+    total.cache_evictions = stat_evictions.get();
+    {
+        epoch_domain::guard guard;
+        for (slab_node* node = head.load(std::memory_order_acquire); node; node = node->next.load(std::memory_order_acquire))
+        {
+            // the nodes' own thread caches are never used, only their pools count
+            slab_stats n = node->value.stats();
+            total.capacity += n.capacity;
+            total.free_bytes += n.free_bytes;
+
+            for (size_t i = 0; i < total.classes.size(); i++)
+            {
+                slab_class_stats& c = total.classes[i];
+                const slab_class_stats& nc = n.classes[i];
+                c.pool.block_size = nc.pool.block_size;
+                c.pool.block_count += nc.pool.block_count;
+                c.pool.free_blocks += nc.pool.free_blocks;
+                c.pool.allocs += nc.pool.allocs;
+                c.pool.frees += nc.pool.frees;
+                c.pool.exhausted += nc.pool.exhausted;
+            }
+        }
+    }
+
+    for (size_t i = 0; i < NUM_SIZE_CLASSES; i++)
+    {
+        slab_class_stats& c = total.classes[i];
+        c.tlc_hits = retired_counters[i].hit_count();
+        c.tlc_refills = retired_counters[i].refill_count();
+        c.tlc_flushes = retired_counters[i].flush_count();
+    }
+
+#if PALLOC_STATS
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    for (const cache_entry* entry = registered; entry; entry = entry->registry_next)
+    {
+        total.thread_caches++;
+        for (size_t i = 0; i < NUM_SIZE_CLASSES; i++)
+        {
+            const tlc_counters& counters = entry->storage[i].counters;
+            slab_class_stats& c = total.classes[i];
+            c.tlc_hits += counters.hit_count();
+            c.tlc_refills += counters.refill_count();
+            c.tlc_flushes += counters.flush_count();
+            c.cached_bytes += counters.cached_blocks() * slab::index_to_size_class(i);
+        }
+    }
+#endif
+
+    for (const auto& c : total.classes)
+        total.cached_bytes += c.cached_bytes;
+
+    return s;
+}
+
 } // namespace AL
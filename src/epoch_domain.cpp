@@ -0,0 +1,83 @@
+#include "epoch_domain.h"
+#include "platform.h"
+#include <mutex>
+
+namespace AL
+{
+
+namespace
+{
+std::mutex registry_mutex;
+
+// one per thread that has ever pinned. lives in that thread's TLS and unlinks itself on exit
+struct thread_record
+{
+    std::atomic<uint64_t>* pinned;
+    thread_record* prev = nullptr;
+    thread_record* next = nullptr;
+
+    static inline thread_record* head = nullptr;
+
+    explicit thread_record(std::atomic<uint64_t>* p) : pinned(p)
+    {
+        std::lock_guard<std::mutex> lock(registry_mutex);
+        next = head;
+        if (head)
+            head->prev = this;
+        head = this;
+    }
+
+    ~thread_record()
+    {
+        std::lock_guard<std::mutex> lock(registry_mutex);
+        if (prev)
+            prev->next = next;
+        else
+            head = next;
+        if (next)
+            next->prev = prev;
+    }
+};
+} // namespace
+
+void epoch_domain::register_thread()
+{
+    static const bool has_process_fence = [] {
+        bool ok = platform_fence::init();
+        if (ok)
+            asymmetric.store(true, std::memory_order_relaxed);
+        return ok;
+    }();
+    (void)has_process_fence;
+
+    // registering takes registry_mutex, so a writer that scans afterwards also sees `asymmetric`
+    thread_local thread_record record(&slot.pinned);
+    (void)record;
+    slot.registered = true;
+}
+
+uint64_t epoch_domain::retire()
+{
+    // release: a reader that pins at the new epoch also sees the unlink that came before it
+    return global_epoch.fetch_add(1, std::memory_order_acq_rel) + 1;
+}
+
+bool epoch_domain::is_safe(uint64_t retire_epoch)
+{
+    std::lock_guard<std::mutex> lock(registry_mutex);
+
+    // orders the caller's unlink before the pin loads below, on this thread and every reader
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (asymmetric.load(std::memory_order_relaxed))
+        platform_fence::heavy();
+
+    for (thread_record* r = thread_record::head; r; r = r->next)
+    {
+        uint64_t pinned = r->pinned->load(std::memory_order_acquire);
+        if (pinned != 0 && pinned < retire_epoch)
+            return false;
+    }
+    return true;
+}
+
+} // namespace AL
@@ -0,0 +1,130 @@
+#include "generational_arena.h"
+#include "platform.h"
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <new>
+
+namespace AL
+{
+generational_arena::generational_arena(size_t bytes) : memory(nullptr), capacity(0), state(0)
+{
+    const size_t page_size = AL::platform_mem::page_size();
+
+    // round up to next page boundary. the end offset, capacity itself, has to fit in offset_bits or
+    // a full generation would carry into the generation bits
+    bytes = std::max<size_t>(bytes, 1);
+    if (bytes > offset_mask)
+        throw std::bad_alloc();
+    capacity = ((bytes + page_size - 1) / page_size) * page_size;
+    if (capacity > offset_mask)
+        throw std::bad_alloc();
+
+    void* ptr = AL::platform_mem::alloc(capacity * 2);
+    if (ptr == nullptr)
+        throw std::bad_alloc();
+
+    memory = static_cast<std::byte*>(ptr);
+}
+
+generational_arena::~generational_arena()
+{
+    bool freed = AL::platform_mem::free(memory, capacity * 2);
+
+#if PALLOC_DEBUG
+    if (!freed)
+    {
+        std::cerr << "WARNING: munmap failed in generational_arena destructor\n";
+    }
+#else
+    (void)freed;
+#endif // PALLOC_DEBUG
+}
+
+void* generational_arena::alloc(size_t length, size_t alignment)
+{
+    if (length == 0 || !std::has_single_bit(alignment))
+        return nullptr;
+
+    uint64_t current = state.load(std::memory_order_relaxed);
+    while (true)
+    {
+        const uint64_t generation = current >> offset_bits;
+        std::byte* half = memory + (generation & 1) * capacity;
+
+        // align the address, see arena::alloc_shared()
+        const uintptr_t base = reinterpret_cast<uintptr_t>(half);
+        const size_t offset = current & offset_mask;
+        const size_t aligned = ((base + offset + alignment - 1) & ~(alignment - 1)) - base;
+        if (aligned > capacity || length > capacity - aligned)
+        {
+            stat_failed.shared_add();
+            return nullptr;
+        }
+
+        // fails if another alloc() bumped the offset or a reset() moved to the next generation
+        if (state.compare_exchange_weak(current, (generation << offset_bits) | (aligned + length), std::memory_order_acq_rel,
+                                        std::memory_order_relaxed))
+            return half + aligned;
+
+        if ((current >> offset_bits) != generation)
+            stat_retries.shared_add();
+    }
+}
+
+void* generational_arena::calloc(size_t length, size_t alignment)
+{
+    void* ptr = alloc(length, alignment);
+
+    if (ptr != nullptr)
+    {
+        std::memset(ptr, 0, length);
+    }
+
+    return ptr;
+}
+
+int generational_arena::reset()
+{
+    // the generation wraps with the word, only its parity picks the half
+    uint64_t current = state.load(std::memory_order_relaxed);
+    while (!state.compare_exchange_weak(current, ((current >> offset_bits) + 1) << offset_bits, std::memory_order_acq_rel,
+                                        std::memory_order_relaxed))
+        ;
+
+    stat_resets.shared_add();
+    return 0;
+}
+
+uint64_t generational_arena::get_generation() const
+{
+    return state.load(std::memory_order_relaxed) >> offset_bits;
+}
+
+size_t generational_arena::get_used() const
+{
+    return state.load(std::memory_order_relaxed) & offset_mask;
+}
+
+size_t generational_arena::get_capacity() const
+{
+    return capacity;
+}
+
+generational_arena_stats generational_arena::stats() const
+{
+    generational_arena_stats s;
+    const uint64_t current = state.load(std::memory_order_relaxed);
+    s.used = current & offset_mask;
+    s.capacity = capacity;
+    s.generation = current >> offset_bits;
+    s.failed_allocs = stat_failed.get();
+    s.resets = stat_resets.get();
+    s.reset_retries = stat_retries.get();
+    return s;
+}
+} // namespace AL
@@ -0,0 +1,93 @@
+#include "page_map.h"
+#include "platform.h"
+
+namespace AL
+{
+
+page_map::~page_map()
+{
+    std::atomic<leaf*>* r = root.load(std::memory_order_acquire);
+    if (r == nullptr)
+        return;
+
+    for (size_t i = 0; i < root_size; i++)
+    {
+        leaf* l = r[i].load(std::memory_order_relaxed);
+        if (l)
+            AL::platform_mem::free(l, sizeof(leaf));
+    }
+    AL::platform_mem::free(r, sizeof(std::atomic<leaf*>) * root_size);
+}
+
+page_map::leaf* page_map::get_or_create_leaf(size_t index)
+{
+    std::atomic<leaf*>* r = root.load(std::memory_order_relaxed);
+    if (r == nullptr)
+    {
+        // fresh anonymous mappings are zero filled, which is a valid null for every slot
+        void* mem = AL::platform_mem::alloc(sizeof(std::atomic<leaf*>) * root_size);
+        if (mem == nullptr)
+            return nullptr;
+        r = static_cast<std::atomic<leaf*>*>(mem);
+        root.store(r, std::memory_order_release);
+    }
+
+    leaf* l = r[index].load(std::memory_order_relaxed);
+    if (l == nullptr)
+    {
+        void* mem = AL::platform_mem::alloc(sizeof(leaf));
+        if (mem == nullptr)
+            return nullptr;
+        l = static_cast<leaf*>(mem);
+        r[index].store(l, std::memory_order_release);
+    }
+    return l;
+}
+
+bool page_map::insert(const void* begin, const void* end, void* owner)
+{
+    if (end <= begin)
+        return true;
+
+#ifdef PALLOC_TESTING
+    if (fail_insert_countdown != 0 && --fail_insert_countdown == 0)
+        return false;
+#endif
+
+    uintptr_t first = reinterpret_cast<uintptr_t>(begin) >> page_shift;
+    uintptr_t last = (reinterpret_cast<uintptr_t>(end) - 1) >> page_shift;
+    if ((last >> (root_bits + leaf_bits)) != 0)
+        return false;
+
+    for (uintptr_t page = first; page <= last; page++)
+    {
+        leaf* l = get_or_create_leaf(page >> leaf_bits);
+        if (l == nullptr)
+        {
+            // leave the map as it was before the call
+            if (page != first)
+                erase(begin, reinterpret_cast<const void*>(page << page_shift));
+            return false;
+        }
+        l->owners[page & (leaf_size - 1)].store(owner, std::memory_order_release);
+    }
+    return true;
+}
+
+void page_map::erase(const void* begin, const void* end)
+{
+    std::atomic<leaf*>* r = root.load(std::memory_order_relaxed);
+    if (r == nullptr || end <= begin)
+        return;
+
+    uintptr_t first = reinterpret_cast<uintptr_t>(begin) >> page_shift;
+    uintptr_t last = (reinterpret_cast<uintptr_t>(end) - 1) >> page_shift;
+    for (uintptr_t page = first; page <= last && (page >> (root_bits + leaf_bits)) == 0; page++)
+    {
+        leaf* l = r[page >> leaf_bits].load(std::memory_order_relaxed);
+        if (l)
+            l->owners[page & (leaf_size - 1)].store(nullptr, std::memory_order_release);
+    }
+}
+
+} // namespace AL
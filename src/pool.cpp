@@ -129,13 +129,17 @@ void* pool::alloc()
 {
     std::lock_guard<std::mutex> lock(alloc_free_mutex);
     if (free_list == nullptr)
+    {
+        stat_exhausted.add();
         return nullptr;
+    }
 
     check_asserts();
 
     auto temp = free_list;
     free_list = free_list->next;
     free_count--;
+    stat_allocs.add();
 
     return temp;
 }
@@ -143,16 +147,25 @@ void* pool::alloc()
 size_t pool::alloc_batched_internal(size_t num_objects, void* out[])
 {
     std::lock_guard<std::mutex> lock(alloc_free_mutex);
-    if (!out || !free_list)
+    if (!out)
         return 0;
 
+    if (!free_list)
+    {
+        stat_exhausted.add();
+        return 0;
+    }
+
     check_asserts();
 
     size_t i = 0;
     for (; i < num_objects; i++)
     {
         if (free_list == nullptr)
-            return i;
+        {
+            stat_exhausted.add();
+            break;
+        }
 
         free_node* temp = free_list;
         free_list = free_list->next;
@@ -160,6 +173,7 @@ size_t pool::alloc_batched_internal(size_t num_objects, void* out[])
         out[i] = temp;
     }
 
+    stat_allocs.add(i);
     return i;
 }
 
@@ -221,6 +235,7 @@ void pool::free(void* ptr)
     free_list = node;
 
     free_count++;
+    stat_frees.add();
 }
 
 void pool::free_batched_internal(size_t num_objects, void* in[])
@@ -243,6 +258,7 @@ void pool::free_batched_internal(size_t num_objects, void* in[])
         free_list = node;
 
         free_count++;
+        stat_frees.add();
     }
 
     return;
@@ -270,6 +286,18 @@ size_t pool::get_block_count() const
     return block_count;
 }
 
+pool_stats pool::stats() const
+{
+    pool_stats s;
+    s.block_size = block_size;
+    s.block_count = block_count;
+    s.free_blocks = free_count.load(std::memory_order_relaxed);
+    s.allocs = stat_allocs.get();
+    s.frees = stat_frees.get();
+    s.exhausted = stat_exhausted.get();
+    return s;
+}
+
 void pool::check_asserts() const
 {
 #if PALLOC_DEBUG
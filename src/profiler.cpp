@@ -0,0 +1,461 @@
+#include "profiler.h"
+#include "platform.h"
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+#if PALLOC_PROFILING
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+
+#ifndef _WIN32
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <fstream>
+#endif
+#endif // PALLOC_PROFILING
+
+namespace AL
+{
+#if PALLOC_PROFILING
+namespace
+{
+constexpr size_t SAMPLE_BITS = 15;
+constexpr size_t SAMPLE_SLOTS = size_t{1} << SAMPLE_BITS; // open addressed table of live samples
+constexpr size_t MAX_LIVE_SAMPLES = SAMPLE_SLOTS / 4 * 3;  // keep probe sequences short
+constexpr size_t STACK_SLOTS = 4096;                       // distinct call stacks
+constexpr size_t STACK_INDEX_SLOTS = STACK_SLOTS * 2;
+
+// while sampling is off a thread rechecks the rate after this many bytes
+constexpr int64_t DISABLED_RECHECK_BYTES = int64_t{1} << 20;
+
+struct stack_record
+{
+    uint64_t hash;
+    size_t depth;
+    size_t live_objects;
+    size_t live_bytes;
+    std::array<void*, heap_profiler::max_frames> frames;
+};
+
+struct sample_record
+{
+    void* ptr; // nullptr marks an empty slot
+    size_t size;
+    size_t stack;
+};
+
+// tables are mapped on the first sample and kept for the life of the process.
+// everything below is guarded by profile_mutex
+struct profile_tables
+{
+    sample_record* samples = nullptr;
+    stack_record* stacks = nullptr;
+    uint32_t* stack_index = nullptr; // 1 based index into stacks, 0 is empty
+    size_t stack_count = 0;
+    size_t live = 0;
+    size_t rate_used = 0; // rate in effect for the most recent sample, used to unsample dumps
+};
+
+std::mutex profile_mutex;
+profile_tables tables;
+std::atomic<size_t> sample_rate{0};
+std::atomic<size_t> dropped{0};
+thread_local uint64_t rng_state = 0;
+
+size_t slot_of(void* ptr)
+{
+    uint64_t key = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(ptr)) >> 3;
+    return static_cast<size_t>((key * 0x9E3779B97F4A7C15ull) >> (64 - SAMPLE_BITS));
+}
+
+// exponentially distributed distance to the next sample, mean `rate` bytes.
+// sampling on a random byte rather than every n-th allocation keeps periodic patterns from hiding
+int64_t next_interval(size_t rate)
+{
+    if (rng_state == 0)
+    {
+        uint64_t seed = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(&rng_state));
+        seed ^= static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+        rng_state = seed | 1;
+    }
+
+    // xorshift64*
+    rng_state ^= rng_state >> 12;
+    rng_state ^= rng_state << 25;
+    rng_state ^= rng_state >> 27;
+    uint64_t r = rng_state * 0x2545F4914F6CDD1Dull;
+
+    double u = (static_cast<double>(r >> 11) + 1.0) * 0x1.0p-53; // (0, 1]
+    double interval = -std::log(u) * static_cast<double>(rate);
+    if (interval < 1.0)
+        return 1;
+    if (interval > static_cast<double>(INT64_MAX / 2))
+        return INT64_MAX / 2;
+    return static_cast<int64_t>(interval);
+}
+
+size_t capture_stack(void** frames, size_t max)
+{
+#ifdef _WIN32
+    return CaptureStackBackTrace(0, static_cast<DWORD>(max), frames, nullptr);
+#else
+    int depth = backtrace(frames, static_cast<int>(max));
+    return depth < 0 ? 0 : static_cast<size_t>(depth);
+#endif
+}
+
+bool map_tables()
+{
+    if (tables.samples)
+        return true;
+
+    void* samples = AL::platform_mem::alloc(sizeof(sample_record) * SAMPLE_SLOTS);
+    void* stacks = AL::platform_mem::alloc(sizeof(stack_record) * STACK_SLOTS);
+    void* index = AL::platform_mem::alloc(sizeof(uint32_t) * STACK_INDEX_SLOTS);
+    if (!samples || !stacks || !index)
+    {
+        if (samples)
+            AL::platform_mem::free(samples, sizeof(sample_record) * SAMPLE_SLOTS);
+        if (stacks)
+            AL::platform_mem::free(stacks, sizeof(stack_record) * STACK_SLOTS);
+        if (index)
+            AL::platform_mem::free(index, sizeof(uint32_t) * STACK_INDEX_SLOTS);
+        return false;
+    }
+
+    // fresh anonymous mappings are zeroed, which is exactly the empty state of every table
+    tables.samples = static_cast<sample_record*>(samples);
+    tables.stacks = static_cast<stack_record*>(stacks);
+    tables.stack_index = static_cast<uint32_t*>(index);
+    return true;
+}
+
+// returns the index of an existing identical stack or adds a new one. STACK_SLOTS if the table is full
+size_t intern_stack(void* const* frames, size_t depth)
+{
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (size_t i = 0; i < depth; i++)
+    {
+        hash ^= static_cast<uint64_t>(reinterpret_cast<uintptr_t>(frames[i]));
+        hash *= 0x100000001b3ull;
+    }
+
+    for (size_t probe = 0; probe < STACK_INDEX_SLOTS; probe++)
+    {
+        uint32_t& slot = tables.stack_index[(hash + probe) % STACK_INDEX_SLOTS];
+        if (slot == 0)
+        {
+            if (tables.stack_count == STACK_SLOTS)
+                return STACK_SLOTS;
+
+            size_t index = tables.stack_count++;
+            stack_record& s = tables.stacks[index];
+            s.hash = hash;
+            s.depth = depth;
+            std::memcpy(s.frames.data(), frames, depth * sizeof(void*));
+            slot = static_cast<uint32_t>(index + 1);
+            return index;
+        }
+
+        stack_record& s = tables.stacks[slot - 1];
+        if (s.hash == hash && s.depth == depth && std::memcmp(s.frames.data(), frames, depth * sizeof(void*)) == 0)
+            return slot - 1;
+    }
+    return STACK_SLOTS;
+}
+
+sample_record* find_sample(void* ptr)
+{
+    for (size_t i = slot_of(ptr);; i = (i + 1) & (SAMPLE_SLOTS - 1))
+    {
+        if (tables.samples[i].ptr == ptr)
+            return &tables.samples[i];
+        if (tables.samples[i].ptr == nullptr)
+            return nullptr;
+    }
+}
+
+// backward shift deletion keeps linear probing correct without tombstones
+void erase_sample(sample_record* record)
+{
+    size_t hole = static_cast<size_t>(record - tables.samples);
+    size_t next = hole;
+    while (true)
+    {
+        next = (next + 1) & (SAMPLE_SLOTS - 1);
+        if (tables.samples[next].ptr == nullptr)
+            break;
+
+        // an entry may only move back if its home slot is not inside (hole, next]
+        size_t home = slot_of(tables.samples[next].ptr);
+        bool stays = hole < next ? (hole < home && home <= next) : (hole < home || home <= next);
+        if (stays)
+            continue;
+
+        tables.samples[hole] = tables.samples[next];
+        hole = next;
+    }
+    tables.samples[hole].ptr = nullptr;
+}
+
+void release_sample(sample_record* record)
+{
+    stack_record& s = tables.stacks[record->stack];
+    s.live_objects--;
+    s.live_bytes -= record->size;
+    tables.live--;
+    erase_sample(record);
+}
+
+// unsampled estimate of the bytes a stack holds. a block of size s is sampled with probability 1 - e^(-s/rate)
+double estimate_bytes(const stack_record& s, size_t rate)
+{
+    if (rate == 0 || s.live_objects == 0)
+        return static_cast<double>(s.live_bytes);
+    double avg = static_cast<double>(s.live_bytes) / static_cast<double>(s.live_objects);
+    double probability = 1.0 - std::exp(-avg / static_cast<double>(rate));
+    return probability > 0.0 ? static_cast<double>(s.live_bytes) / probability : static_cast<double>(s.live_bytes);
+}
+
+void write_frame_name(std::ostream& out, void* addr)
+{
+#ifndef _WIN32
+    Dl_info info;
+    if (dladdr(addr, &info) != 0)
+    {
+        if (info.dli_sname)
+        {
+            int status = 0;
+            char* demangled = abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+            out << (status == 0 && demangled ? demangled : info.dli_sname);
+            std::free(demangled);
+            return;
+        }
+        if (info.dli_fname)
+        {
+            const char* name = std::strrchr(info.dli_fname, '/');
+            out << (name ? name + 1 : info.dli_fname) << "+0x" << std::hex
+                << (reinterpret_cast<uintptr_t>(addr) - reinterpret_cast<uintptr_t>(info.dli_fbase)) << std::dec;
+            return;
+        }
+    }
+#endif
+    out << "0x" << std::hex << reinterpret_cast<uintptr_t>(addr) << std::dec;
+}
+} // namespace
+
+void heap_profiler::set_sample_rate(size_t bytes)
+{
+    sample_rate.store(bytes, std::memory_order_relaxed);
+    bytes_until_sample = bytes == 0 ? DISABLED_RECHECK_BYTES : next_interval(bytes);
+}
+
+size_t heap_profiler::get_sample_rate()
+{
+    return sample_rate.load(std::memory_order_relaxed);
+}
+
+size_t heap_profiler::get_live_samples()
+{
+    return live_count.load(std::memory_order_relaxed);
+}
+
+size_t heap_profiler::get_dropped_samples()
+{
+    return dropped.load(std::memory_order_relaxed);
+}
+
+void heap_profiler::record(void* ptr, size_t size)
+{
+    size_t rate = sample_rate.load(std::memory_order_relaxed);
+    if (rate == 0)
+    {
+        bytes_until_sample = DISABLED_RECHECK_BYTES;
+        return;
+    }
+    bytes_until_sample = next_interval(rate);
+
+    // one extra frame for record() itself
+    std::array<void*, max_frames + 1> frames;
+    size_t depth = capture_stack(frames.data(), frames.size());
+    void* const* first = depth > 0 ? frames.data() + 1 : frames.data();
+    depth = depth > 0 ? depth - 1 : 0;
+
+    std::lock_guard<std::mutex> lock(profile_mutex);
+    if (!map_tables() || tables.live >= MAX_LIVE_SAMPLES)
+    {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    size_t stack = intern_stack(first, depth);
+    if (stack == STACK_SLOTS)
+    {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    // a block can come back without a free in between (slab::reset), replace the stale sample
+    if (sample_record* stale = find_sample(ptr))
+    {
+        release_sample(stale);
+        live_count.store(tables.live, std::memory_order_relaxed);
+    }
+    else
+    {
+        auto& counter = filter[filter_index(ptr)];
+        uint8_t count = counter.load(std::memory_order_relaxed);
+        if (count != UINT8_MAX) // saturated slots stay set until clear()
+            counter.store(count + 1, std::memory_order_relaxed);
+    }
+
+    size_t slot = slot_of(ptr);
+    while (tables.samples[slot].ptr != nullptr)
+        slot = (slot + 1) & (SAMPLE_SLOTS - 1);
+    tables.samples[slot] = {ptr, size, stack};
+
+    stack_record& s = tables.stacks[stack];
+    s.live_objects++;
+    s.live_bytes += size;
+    tables.live++;
+    tables.rate_used = rate;
+    live_count.store(tables.live, std::memory_order_relaxed);
+}
+
+void heap_profiler::forget(void* ptr)
+{
+    std::lock_guard<std::mutex> lock(profile_mutex);
+    if (!tables.samples)
+        return;
+
+    sample_record* record = find_sample(ptr);
+    if (!record)
+        return; // filter false positive
+
+    release_sample(record);
+
+    auto& counter = filter[filter_index(ptr)];
+    uint8_t count = counter.load(std::memory_order_relaxed);
+    if (count != UINT8_MAX)
+        counter.store(count - 1, std::memory_order_relaxed);
+
+    live_count.store(tables.live, std::memory_order_relaxed);
+}
+
+void heap_profiler::clear()
+{
+    std::lock_guard<std::mutex> lock(profile_mutex);
+    if (tables.samples)
+    {
+        std::memset(static_cast<void*>(tables.samples), 0, sizeof(sample_record) * SAMPLE_SLOTS);
+        std::memset(static_cast<void*>(tables.stacks), 0, sizeof(stack_record) * tables.stack_count);
+        std::memset(tables.stack_index, 0, sizeof(uint32_t) * STACK_INDEX_SLOTS);
+    }
+    tables.stack_count = 0;
+    tables.live = 0;
+
+    for (auto& counter : filter)
+        counter.store(0, std::memory_order_relaxed);
+    live_count.store(0, std::memory_order_relaxed);
+}
+
+void heap_profiler::write_pprof(std::ostream& out)
+{
+    std::lock_guard<std::mutex> lock(profile_mutex);
+
+    size_t objects = 0;
+    size_t bytes = 0;
+    for (size_t i = 0; i < tables.stack_count; i++)
+    {
+        objects += tables.stacks[i].live_objects;
+        bytes += tables.stacks[i].live_bytes;
+    }
+
+    // only live samples are tracked, so the in-use and allocated columns are the same
+    out << "heap profile: " << objects << ": " << bytes << " [" << objects << ": " << bytes << "] @ heap_v2/" << tables.rate_used
+        << "\n";
+
+    for (size_t i = 0; i < tables.stack_count; i++)
+    {
+        const stack_record& s = tables.stacks[i];
+        if (s.live_objects == 0)
+            continue;
+
+        out << s.live_objects << ": " << s.live_bytes << " [" << s.live_objects << ": " << s.live_bytes << "] @";
+        out << std::hex;
+        for (size_t f = 0; f < s.depth; f++)
+            out << " 0x" << reinterpret_cast<uintptr_t>(s.frames[f]);
+        out << std::dec << "\n";
+    }
+
+#ifndef _WIN32
+    // pprof needs the load addresses of every module to symbolize the raw frames
+    out << "\nMAPPED_LIBRARIES:\n";
+    std::ifstream maps("/proc/self/maps");
+    out << maps.rdbuf();
+#endif
+}
+
+void heap_profiler::write_collapsed(std::ostream& out)
+{
+    std::lock_guard<std::mutex> lock(profile_mutex);
+
+    for (size_t i = 0; i < tables.stack_count; i++)
+    {
+        const stack_record& s = tables.stacks[i];
+        if (s.live_objects == 0)
+            continue;
+
+        // collapsed stacks are written root first
+        for (size_t f = s.depth; f > 0; f--)
+        {
+            write_frame_name(out, s.frames[f - 1]);
+            if (f > 1)
+                out << ';';
+        }
+        out << ' ' << static_cast<uint64_t>(estimate_bytes(s, tables.rate_used)) << "\n";
+    }
+}
+
+#else // PALLOC_PROFILING
+
+void heap_profiler::set_sample_rate(size_t bytes)
+{
+    (void)bytes;
+}
+
+size_t heap_profiler::get_sample_rate()
+{
+    return 0;
+}
+
+size_t heap_profiler::get_live_samples()
+{
+    return 0;
+}
+
+size_t heap_profiler::get_dropped_samples()
+{
+    return 0;
+}
+
+void heap_profiler::write_pprof(std::ostream& out)
+{
+    (void)out;
+}
+
+void heap_profiler::write_collapsed(std::ostream& out)
+{
+    (void)out;
+}
+
+void heap_profiler::clear()
+{}
+
+#endif // PALLOC_PROFILING
+} // namespace AL
@@ -0,0 +1,104 @@
+#include "request_heap.h"
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstring>
+
+namespace AL
+{
+request_heap::request_heap(size_t bytes) : backing(bytes)
+{}
+
+size_t request_heap::class_index(size_t length, size_t alignment)
+{
+    if (alignment > default_alignment)
+        return static_cast<size_t>(-1);
+    // a class at least as large as the alignment is carved at that alignment, so every block of it,
+    // recycled or not, meets the request
+    return slab::size_to_index(std::max(length, alignment));
+}
+
+void* request_heap::alloc(size_t length, size_t alignment)
+{
+    if (length == 0 || !std::has_single_bit(alignment))
+        return nullptr;
+
+    const size_t index = class_index(length, alignment);
+    if (index == static_cast<size_t>(-1))
+    {
+        void* ptr = backing.alloc(length, alignment);
+        if (ptr == nullptr)
+            stat_failed.add();
+        return ptr;
+    }
+
+    if (free_block* block = free_lists[index])
+    {
+        free_lists[index] = block->next;
+        stat_recycled.add();
+        return block;
+    }
+
+    const size_t size = slab::index_to_size_class(index);
+    void* ptr = backing.alloc(size, std::min(size, default_alignment));
+    if (ptr == nullptr)
+        stat_failed.add();
+    return ptr;
+}
+
+void* request_heap::calloc(size_t length, size_t alignment)
+{
+    void* ptr = alloc(length, alignment);
+
+    if (ptr != nullptr)
+    {
+        std::memset(ptr, 0, length);
+    }
+
+    return ptr;
+}
+
+void request_heap::free(void* ptr, size_t length, size_t alignment)
+{
+    if (ptr == nullptr)
+        return;
+
+    const size_t index = class_index(length, alignment);
+    if (index == static_cast<size_t>(-1))
+        return;
+
+    auto* block = static_cast<free_block*>(ptr);
+    block->next = free_lists[index];
+    free_lists[index] = block;
+    stat_frees.add();
+}
+
+int request_heap::reset()
+{
+    free_lists.fill(nullptr);
+    stat_resets.add();
+    return backing.reset();
+}
+
+size_t request_heap::get_used() const
+{
+    return backing.get_used();
+}
+
+size_t request_heap::get_capacity() const
+{
+    return backing.get_capacity();
+}
+
+request_heap_stats request_heap::stats() const
+{
+    request_heap_stats s;
+    s.used = get_used();
+    s.capacity = get_capacity();
+    s.recycled = stat_recycled.get();
+    s.frees = stat_frees.get();
+    s.failed_allocs = stat_failed.get();
+    s.resets = stat_resets.get();
+    return s;
+}
+} // namespace AL
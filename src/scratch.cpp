@@ -0,0 +1,94 @@
+#include "scratch.h"
+#include "platform.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+
+namespace AL
+{
+constinit thread_local scratch_scope::thread_state scratch_scope::state;
+
+namespace
+{
+// unmaps the calling thread's region at thread exit. only constructed once a region is mapped,
+// so threads that never use scratch memory pay nothing
+struct region_reaper
+{
+    std::byte** memory;
+    size_t* capacity;
+
+    ~region_reaper()
+    {
+        if (*memory == nullptr)
+            return;
+
+        bool freed = AL::platform_mem::free(*memory, *capacity);
+
+#if PALLOC_DEBUG
+        if (!freed)
+        {
+            std::cerr << "WARNING: munmap failed releasing a thread's scratch region\n";
+        }
+#else
+        (void)freed;
+#endif // PALLOC_DEBUG
+        *memory = nullptr;
+        *capacity = 0;
+    }
+};
+} // namespace
+
+void* scratch_scope::alloc_slow(size_t length, size_t alignment)
+{
+    if (state.memory != nullptr)
+        return nullptr;
+
+    const size_t page_size = AL::platform_mem::page_size();
+    const size_t bytes = ((std::max<size_t>(state.reserve, 1) + page_size - 1) / page_size) * page_size;
+    void* ptr = AL::platform_mem::alloc(bytes);
+    if (ptr == nullptr)
+        return nullptr;
+
+    thread_local region_reaper reaper{&state.memory, &state.capacity};
+    (void)reaper;
+
+    state.memory = static_cast<std::byte*>(ptr);
+    state.capacity = bytes;
+
+    const uintptr_t base = reinterpret_cast<uintptr_t>(state.memory);
+    const size_t aligned = ((base + state.used + alignment - 1) & ~(alignment - 1)) - base;
+    if (aligned > state.capacity || length > state.capacity - aligned)
+        return nullptr;
+
+    state.used = aligned + length;
+    return state.memory + aligned;
+}
+
+int scratch_scope::set_thread_reserve(size_t bytes)
+{
+    if (state.used != 0)
+        return -1;
+
+    if (state.memory != nullptr)
+    {
+        if (!AL::platform_mem::free(state.memory, state.capacity))
+            return -1;
+        state.memory = nullptr;
+        state.capacity = 0;
+    }
+
+    state.reserve = bytes;
+    return 0;
+}
+
+size_t scratch_scope::get_thread_used()
+{
+    return state.used;
+}
+
+size_t scratch_scope::get_thread_capacity()
+{
+    return state.capacity;
+}
+} // namespace AL
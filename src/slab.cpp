@@ -1,11 +1,16 @@
 #include "slab.h"
+#include "platform.h"
 #include "pool.h"
+#include "profiler.h"
+#include <algorithm>
 #include <array>
 #include <cmath>
 #include <cstddef>
 #include <cstring>
 #include <iterator>
+#include <mutex>
 #include <strings.h>
+#include <thread>
 
 namespace AL
 {
@@ -13,6 +18,120 @@ namespace AL
 thread_local std::array<slab::cache_entry, slab::MAX_CACHED_SLABS> slab::caches = {};
 std::atomic<size_t> slab::next_slab_id{0};
 
+namespace
+{
+std::atomic<uint64_t> next_thread_id{0};
+} // namespace
+
+// one per thread that has ever claimed a cache entry. lives in that thread's TLS,
+// so it must detach its entries before the thread's storage goes away
+struct slab::thread_registration
+{
+    // held by this thread while it evicts or exits, and by a slab that detaches or drops one of its entries
+    std::mutex mutex;
+    std::array<cache_entry, MAX_CACHED_SLABS>* entries;
+    uint64_t id;
+
+    thread_registration() : entries(&caches), id(next_thread_id.fetch_add(1, std::memory_order_relaxed))
+    {}
+
+    ~thread_registration()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        // owners are alive here: ~slab() needs this lock to detach the entries it still owns
+        for (cache_entry& entry : *entries)
+        {
+            if (slab* owner = entry.owner.load(std::memory_order_relaxed))
+                owner->detach(entry);
+        }
+    }
+};
+
+slab::thread_registration& slab::register_thread()
+{
+    thread_local thread_registration registration;
+    return registration;
+}
+
+template<typename F>
+void slab::for_each_registered_entry(F&& fn)
+{
+    std::unique_lock<std::mutex> lock(registry_mutex);
+    cache_entry* entry = registered;
+    while (entry)
+    {
+        std::unique_lock<std::mutex> thread_lock(entry->thread->mutex, std::try_to_lock);
+        if (!thread_lock.owns_lock())
+        {
+            // the thread is evicting or exiting and waits for registry_mutex with its own lock held.
+            // let it finish, then start over since it may have unlinked entries
+            lock.unlock();
+            std::this_thread::yield();
+            lock.lock();
+            entry = registered;
+            continue;
+        }
+
+        cache_entry* next = entry->registry_next;
+        fn(*entry);
+        entry = next;
+    }
+}
+
+void slab::attach(cache_entry& entry, thread_registration& thread)
+{
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    entry.thread = &thread;
+    entry.registry_prev = nullptr;
+    entry.registry_next = registered;
+    if (registered)
+        registered->registry_prev = &entry;
+    registered = &entry;
+    entry.owner.store(this, std::memory_order_relaxed);
+}
+
+void slab::detach(cache_entry& entry)
+{
+    std::lock_guard<std::mutex> lock(registry_mutex);
+
+    // blocks cached before a reset() were already returned by it
+    if (entry.epoch != epoch.load(std::memory_order_acquire))
+        entry.invalidate_all();
+    else
+        entry.flush();
+
+    for (size_t i = 0; i < NUM_CACHED_CLASSES; i++)
+    {
+        retired_counters[i].absorb(entry.storage[i].counters);
+        entry.storage[i].counters.clear();
+    }
+
+    if (entry.registry_prev)
+        entry.registry_prev->registry_next = entry.registry_next;
+    else
+        registered = entry.registry_next;
+    if (entry.registry_next)
+        entry.registry_next->registry_prev = entry.registry_prev;
+    entry.registry_prev = nullptr;
+    entry.registry_next = nullptr;
+    entry.owner.store(nullptr, std::memory_order_relaxed);
+}
+
+void slab::evict(cache_entry& entry)
+{
+    stat_evictions.shared_add();
+
+    thread_registration& thread = register_thread();
+    std::lock_guard<std::mutex> lock(thread.mutex);
+
+    // the thread lock keeps the old owner from finishing its destructor under us
+    if (slab* old = entry.owner.load(std::memory_order_relaxed))
+        old->detach(entry);
+
+    attach(entry, thread);
+}
+
 slab::slab(size_t scale) : epoch(0), slab_id(next_slab_id.fetch_add(1, std::memory_order_relaxed))
 {
     for (size_t i = 0; i < shared_pools.size(); i++)
@@ -26,26 +145,20 @@ slab::slab(size_t scale) : epoch(0), slab_id(next_slab_id.fetch_add(1, std::memo
 
 slab::~slab()
 {
-    // Check preferred slot first (O(1) fast path)
-    const size_t preferred = slab_id % MAX_CACHED_SLABS;
-    if (caches[preferred].owner == this)
-    {
-        caches[preferred].invalidate_all();
-        caches[preferred].owner = nullptr;
-        return;
-    }
-    // Fallback scan: entry may have been displaced to another slot
-    for (size_t i = 0; i < MAX_CACHED_SLABS; ++i)
-    {
-        if (i == preferred)
-            continue;
-        if (caches[i].owner == this)
-        {
-            caches[i].invalidate_all();
-            caches[i].owner = nullptr;
-            return;
-        }
-    }
+    // other threads may still be running. each entry is dropped under its thread's lock, so
+    // none of them can be flushing into this slab when the release store below hands the slot back
+    for_each_registered_entry([this](cache_entry& entry) {
+        entry.invalidate_all();
+        for (auto& cache : entry.storage)
+            cache.counters.clear();
+
+        if (entry.registry_next)
+            entry.registry_next->registry_prev = nullptr;
+        registered = entry.registry_next;
+        entry.registry_prev = nullptr;
+        entry.registry_next = nullptr;
+        entry.owner.store(nullptr, std::memory_order_release);
+    });
 }
 
 void* slab::alloc(size_t size)
@@ -79,6 +192,8 @@ void* slab::alloc(size_t size)
         if (auto elem = cache.try_pop())
         {
             // cache hit
+            cache.counters.on_hit();
+            heap_profiler::on_alloc(elem, SIZE_CLASS_CONFIG[index].first);
             return elem;
         }
         else
@@ -86,13 +201,20 @@ void* slab::alloc(size_t size)
             // cache miss
             size_t num_allocated = pool.alloc_batched_internal(cache.batch_size, cache.objects.data());
             cache.current = num_allocated;
+            cache.counters.on_refill();
 
-            return cache.try_pop();
+            void* refilled = cache.try_pop();
+            if (refilled)
+                heap_profiler::on_alloc(refilled, SIZE_CLASS_CONFIG[index].first);
+            return refilled;
         }
     }
     else
     {
-        return pool.alloc();
+        void* elem = pool.alloc();
+        if (elem)
+            heap_profiler::on_alloc(elem, SIZE_CLASS_CONFIG[index].first);
+        return elem;
     }
 }
 
@@ -117,6 +239,13 @@ void slab::reset()
         pool.reset();
     }
     epoch.fetch_add(1, std::memory_order_release);
+
+    // the epoch alone makes each thread drop its blocks on its next call. dropping them now
+    // keeps stats and is_unused() from counting blocks the pools already got back
+    for_each_registered_entry([this](cache_entry& entry) {
+        entry.invalidate_all();
+        entry.epoch = epoch.load(std::memory_order_relaxed);
+    });
 }
 
 void slab::free(void* ptr, size_t size)
@@ -132,6 +261,8 @@ void slab::free(void* ptr, size_t size)
         return;
     }
 
+    heap_profiler::on_free(ptr);
+
     pool& pool = shared_pools[index];
     if (index < NUM_CACHED_CLASSES)
     {
@@ -150,6 +281,7 @@ void slab::free(void* ptr, size_t size)
         {
             pool.free_batched_internal(cache.batch_size, cache.objects.data() + (cache.current - cache.batch_size));
             cache.current -= cache.batch_size;
+            cache.counters.on_flush();
         }
 
         cache.push(ptr);
@@ -176,6 +308,22 @@ size_t slab::get_total_capacity() const
     return total;
 }
 
+size_t slab::capacity_for_scale(size_t scale)
+{
+    // mirrors slab::slab() and pool::init()
+    const size_t page_size = AL::platform_mem::page_size();
+    size_t total = 0;
+    for (const auto& [block_size, blocks] : SIZE_CLASS_CONFIG)
+    {
+        size_t count = static_cast<size_t>(std::ceil(blocks * scale));
+        if (count < 1)
+            count = 1;
+        const size_t needed = std::bit_ceil(std::max(block_size, sizeof(void*))) * count;
+        total += ((needed + page_size - 1) / page_size) * page_size;
+    }
+    return total;
+}
+
 size_t slab::get_total_free() const
 {
     size_t total = 0;
@@ -198,6 +346,20 @@ size_t slab::get_pool_free_space(size_t index) const
     return shared_pools[index].get_free_space();
 }
 
+std::byte* slab::get_pool_memory_start(size_t index) const
+{
+    if (index >= NUM_SIZE_CLASSES)
+        return nullptr;
+    return shared_pools[index].get_memory_start();
+}
+
+std::byte* slab::get_pool_memory_end(size_t index) const
+{
+    if (index >= NUM_SIZE_CLASSES)
+        return nullptr;
+    return shared_pools[index].get_memory_end();
+}
+
 bool slab::owns(void* ptr) const
 {
     for (const auto& pool : shared_pools)
@@ -207,4 +369,102 @@ bool slab::owns(void* ptr) const
     return false;
 }
 
+bool slab::is_unused() const
+{
+    for (const auto& pool : shared_pools)
+        if (pool.free_count.load(std::memory_order_acquire) != pool.block_count)
+            return false;
+
+    return true;
+}
+
+void slab::flush_thread_cache()
+{
+    for (cache_entry& entry : caches)
+    {
+        if (entry.owner.load(std::memory_order_relaxed) != this)
+            continue;
+
+        // blocks cached before a reset() were already returned by it
+        if (entry.epoch != epoch.load(std::memory_order_acquire))
+            entry.invalidate_all();
+        else
+            entry.flush();
+    }
+}
+
+size_t slab::alloc_batch(size_t index, size_t count, void** out)
+{
+    if (index >= NUM_SIZE_CLASSES)
+        return 0;
+    return shared_pools[index].alloc_batched_internal(count, out);
+}
+
+void slab::free_batch(size_t index, size_t count, void** blocks)
+{
+    if (index >= NUM_SIZE_CLASSES)
+        return;
+    shared_pools[index].free_batched_internal(count, blocks);
+}
+
+slab_stats slab::stats() const
+{
+    slab_stats s;
+    s.capacity = get_total_capacity();
+    s.free_bytes = get_total_free();
+    s.cache_evictions = stat_evictions.get();
+
+    for (size_t i = 0; i < NUM_SIZE_CLASSES; i++)
+    {
+        slab_class_stats& c = s.classes[i];
+        c.pool = shared_pools[i].stats();
+        c.tlc_hits = retired_counters[i].hit_count();
+        c.tlc_refills = retired_counters[i].refill_count();
+        c.tlc_flushes = retired_counters[i].flush_count();
+    }
+
+#if PALLOC_STATS
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    for (const cache_entry* entry = registered; entry; entry = entry->registry_next)
+    {
+        s.thread_caches++;
+        for (size_t i = 0; i < NUM_CACHED_CLASSES; i++)
+        {
+            const tlc_counters& counters = entry->storage[i].counters;
+            slab_class_stats& c = s.classes[i];
+            c.tlc_hits += counters.hit_count();
+            c.tlc_refills += counters.refill_count();
+            c.tlc_flushes += counters.flush_count();
+            c.cached_bytes += counters.cached_blocks() * c.pool.block_size;
+        }
+    }
+#endif
+
+    for (const auto& c : s.classes)
+        s.cached_bytes += c.cached_bytes;
+
+    return s;
+}
+
+void slab::visit_thread_caches(void (*fn)(const thread_cache_stats&, void*), void* ctx) const
+{
+#if PALLOC_STATS
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    for (const cache_entry* entry = registered; entry; entry = entry->registry_next)
+    {
+        thread_cache_stats t;
+        t.thread_id = entry->thread->id;
+        for (size_t i = 0; i < NUM_CACHED_CLASSES; i++)
+        {
+            t.cached_bytes[i] = entry->storage[i].counters.cached_blocks() * SIZE_CLASS_CONFIG[i].first;
+            t.total_bytes += t.cached_bytes[i];
+        }
+        fn(t, ctx);
+    }
+#else
+    (void)fn;
+    (void)ctx;
+#endif
+}
+
 } // namespace AL
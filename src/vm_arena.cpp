@@ -0,0 +1,158 @@
+#include "vm_arena.h"
+#include "platform.h"
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <new>
+
+namespace AL
+{
+namespace
+{
+size_t round_to_pages(size_t bytes)
+{
+    const size_t page_size = AL::platform_mem::page_size();
+    return ((bytes + page_size - 1) / page_size) * page_size;
+}
+} // namespace
+
+vm_arena::vm_arena(size_t reserve_bytes, size_t step)
+    : memory(nullptr), used(0), committed(0), reserved(round_to_pages(std::max<size_t>(reserve_bytes, 1))),
+      commit_step(round_to_pages(std::max<size_t>(step, 1))), retained_bytes(static_cast<size_t>(-1))
+{
+    void* ptr = AL::platform_mem::reserve(reserved);
+    if (ptr == nullptr)
+        throw std::bad_alloc();
+
+    memory = static_cast<std::byte*>(ptr);
+}
+
+vm_arena::~vm_arena()
+{
+    bool freed = AL::platform_mem::free(memory, reserved);
+
+#if PALLOC_DEBUG
+    if (!freed)
+    {
+        std::cerr << "WARNING: munmap failed in vm_arena destructor\n";
+    }
+#else
+    (void)freed;
+#endif // PALLOC_DEBUG
+}
+
+void* vm_arena::alloc(size_t length, size_t alignment)
+{
+    if (length == 0 || !std::has_single_bit(alignment))
+        return nullptr;
+
+    const uintptr_t base = reinterpret_cast<uintptr_t>(memory);
+
+    size_t current = used.load(std::memory_order_relaxed);
+    size_t aligned;
+    while (true)
+    {
+        // align the address, see arena::alloc_shared()
+        aligned = ((base + current + alignment - 1) & ~(alignment - 1)) - base;
+        if (aligned > reserved || length > reserved - aligned)
+        {
+            stat_failed.shared_add();
+            return nullptr;
+        }
+
+        if (used.compare_exchange_weak(current, aligned + length, std::memory_order_release, std::memory_order_relaxed))
+            break;
+    }
+
+    // O(1) fast path: the range is already committed
+    const size_t end = aligned + length;
+    if (end <= committed.load(std::memory_order_acquire) || commit_to(end))
+        return memory + aligned;
+
+    // give the range back if nobody allocated behind it, so a later smaller request can still fit
+    size_t expected = end;
+    used.compare_exchange_strong(expected, current, std::memory_order_relaxed);
+    stat_failed.shared_add();
+    return nullptr;
+}
+
+bool vm_arena::commit_to(size_t end)
+{
+    std::lock_guard<std::mutex> lock(commit_mutex);
+    const size_t have = committed.load(std::memory_order_relaxed);
+    if (end <= have)
+        return true;
+
+    // whole steps, so a run of small allocations does not commit page by page
+    size_t target = ((end + commit_step - 1) / commit_step) * commit_step;
+    target = std::min(target, reserved);
+    if (!AL::platform_mem::commit(memory + have, target - have))
+        return false;
+
+    stat_commits.add();
+    committed.store(target, std::memory_order_release);
+    return true;
+}
+
+void* vm_arena::calloc(size_t length, size_t alignment)
+{
+    void* ptr = alloc(length, alignment);
+
+    if (ptr != nullptr)
+    {
+        std::memset(ptr, 0, length);
+    }
+
+    return ptr;
+}
+
+int vm_arena::reset()
+{
+    used.store(0, std::memory_order_relaxed);
+    stat_resets.add();
+
+    const size_t have = committed.load(std::memory_order_relaxed);
+    const size_t keep = retained_bytes >= have ? have : round_to_pages(retained_bytes);
+    if (keep >= have)
+        return 0;
+
+    committed.store(keep, std::memory_order_relaxed);
+    return AL::platform_mem::decommit(memory + keep, have - keep) ? 0 : -1;
+}
+
+void vm_arena::set_retained_bytes(size_t bytes)
+{
+    retained_bytes = bytes;
+}
+
+size_t vm_arena::get_used() const
+{
+    return used.load(std::memory_order_relaxed);
+}
+
+size_t vm_arena::get_committed() const
+{
+    return committed.load(std::memory_order_relaxed);
+}
+
+size_t vm_arena::get_reserved() const
+{
+    return reserved;
+}
+
+vm_arena_stats vm_arena::stats() const
+{
+    vm_arena_stats s;
+    s.used = get_used();
+    s.committed = get_committed();
+    s.reserved = get_reserved();
+    s.commits = stat_commits.get();
+    s.failed_allocs = stat_failed.get();
+    s.resets = stat_resets.get();
+    return s;
+}
+} // namespace AL
@@ -1,7 +1,11 @@
 #include "arena.h"
+#include <algorithm>
 #include <chrono>
+#include <cstdint>
+#include <cstring>
 #include <iostream>
 #include <unistd.h>
+#include <utility>
 #include <vector>
 
 using namespace AL;
@@ -158,6 +162,123 @@ int main()
         std::cout << "[PASSED] Test 2: Repeated alloc/reset cycles\n" << std::endl;
     }
 
+    // ========================================================================
+    // Test 3: Bytes consumed by mixed small allocations, default vs natural alignment
+    // ========================================================================
+    {
+        std::cout << "--- Test 3: Mixed Small Allocations, Alignment Overhead ---" << std::endl;
+
+        const size_t MIXED_ALLOCS = 1000000;
+        // <size, natural alignment> of typical small objects: chars, shorts, ints, pointers, small structs
+        const std::pair<size_t, size_t> MIX[] = {{1, 1}, {2, 2}, {3, 1}, {4, 4}, {6, 2}, {8, 8}, {12, 4}, {16, 8}, {24, 8}, {32, 8}};
+        const size_t MIX_COUNT = sizeof(MIX) / sizeof(MIX[0]);
+
+        size_t payload = 0;
+        for (size_t i = 0; i < MIXED_ALLOCS; ++i)
+            payload += MIX[i % MIX_COUNT].first;
+
+        AL::arena defaulted(MIXED_ALLOCS * alignof(std::max_align_t) * 3);
+        AL::arena natural(MIXED_ALLOCS * alignof(std::max_align_t) * 3);
+
+        auto start = std::chrono::high_resolution_clock::now();
+        for (size_t i = 0; i < MIXED_ALLOCS; ++i)
+        {
+            if (defaulted.alloc(MIX[i % MIX_COUNT].first) == nullptr)
+            {
+                std::cerr << "ERROR: Default aligned allocation failed at " << i << std::endl;
+                return 1;
+            }
+        }
+        auto mid = std::chrono::high_resolution_clock::now();
+        for (size_t i = 0; i < MIXED_ALLOCS; ++i)
+        {
+            const auto& [size, alignment] = MIX[i % MIX_COUNT];
+            void* ptr = natural.alloc(size, alignment);
+            if (ptr == nullptr || reinterpret_cast<uintptr_t>(ptr) % alignment != 0)
+            {
+                std::cerr << "ERROR: Naturally aligned allocation failed at " << i << std::endl;
+                return 1;
+            }
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+
+        std::chrono::duration<double> default_time = mid - start;
+        std::chrono::duration<double> natural_time = end - mid;
+
+        std::cout << "Payload:            " << payload << " bytes in " << MIXED_ALLOCS << " allocations" << std::endl;
+        std::cout << "Default alignment:  " << defaulted.get_used() << " bytes used ("
+                  << (static_cast<double>(defaulted.get_used()) / payload) << "x payload), "
+                  << (default_time.count() * 1e9 / MIXED_ALLOCS) << " ns/alloc" << std::endl;
+        std::cout << "Natural alignment:  " << natural.get_used() << " bytes used ("
+                  << (static_cast<double>(natural.get_used()) / payload) << "x payload), "
+                  << (natural_time.count() * 1e9 / MIXED_ALLOCS) << " ns/alloc" << std::endl;
+        std::cout << "[PASSED] Test 3: Alignment overhead\n" << std::endl;
+    }
+
+    // ========================================================================
+    // Test 4: Resident memory over a skewed workload
+    // ========================================================================
+    {
+        std::cout << "--- Test 4: Resident Memory, Skewed Request Sizes ---" << std::endl;
+
+        const size_t CYCLES = 400;
+        const size_t TYPICAL = 256 * 1024;
+        const size_t OUTLIER = 64 * 1024 * 1024;
+        const size_t OUTLIER_EVERY = 100;
+        std::cout << "Cycles: " << CYCLES << ", typical " << TYPICAL / 1024 << " KB, every " << OUTLIER_EVERY
+                  << "th is " << OUTLIER / (1024 * 1024) << " MB" << std::endl;
+
+        struct policy
+        {
+            const char* name;
+            size_t retained;
+            unsigned decay;
+        };
+        const policy policies[] = {
+            {"keep everything (default)", static_cast<size_t>(-1), 0},
+            {"retain 1 MB", 1024 * 1024, 0},
+            {"high-water, 50% decay", static_cast<size_t>(-1), 50},
+        };
+
+        for (const policy& p : policies)
+        {
+            AL::arena a(OUTLIER + PAGE_SIZE);
+            a.set_retained_bytes(p.retained);
+            a.set_high_water_decay(p.decay);
+
+            size_t resident_sum = 0;
+            size_t resident_max = 0;
+            auto start = std::chrono::high_resolution_clock::now();
+            for (size_t cycle = 0; cycle < CYCLES; ++cycle)
+            {
+                const size_t bytes = (cycle % OUTLIER_EVERY == OUTLIER_EVERY / 2) ? OUTLIER : TYPICAL;
+                void* ptr = a.alloc(bytes);
+                if (ptr == nullptr)
+                {
+                    std::cerr << "ERROR: Allocation failed in cycle " << cycle << std::endl;
+                    return 1;
+                }
+                std::memset(ptr, static_cast<int>(cycle & 0xFF), bytes);
+                if (a.reset() != 0)
+                {
+                    std::cerr << "ERROR: Reset failed in cycle " << cycle << std::endl;
+                    return 1;
+                }
+
+                const size_t resident = a.get_resident();
+                resident_sum += resident;
+                resident_max = std::max(resident_max, resident);
+            }
+            auto end = std::chrono::high_resolution_clock::now();
+            std::chrono::duration<double> diff = end - start;
+
+            std::cout << "  " << p.name << ": avg resident after reset " << (resident_sum / CYCLES / 1024) << " KB, max "
+                      << (resident_max / 1024) << " KB, final " << (a.get_resident() / 1024) << " KB, "
+                      << (diff.count() * 1e3) << " ms" << std::endl;
+        }
+        std::cout << "[PASSED] Test 4: Resident memory\n" << std::endl;
+    }
+
     std::cout << "========================================" << std::endl;
     std::cout << "[PASSED] All arena stress tests passed!" << std::endl;
     std::cout << "========================================\n" << std::endl;
@@ -0,0 +1,116 @@
+#include "arena.h"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+using namespace AL;
+
+namespace
+{
+void wait_for_start(const std::atomic<bool>& start)
+{
+    while (!start.load(std::memory_order_acquire))
+        std::this_thread::yield();
+}
+
+double ns_per_op(double elapsed_s, size_t ops)
+{
+    return (elapsed_s * 1e9) / static_cast<double>(ops);
+}
+
+double throughput(double elapsed_s, size_t ops)
+{
+    return static_cast<double>(ops) / elapsed_s / 1e6; // MOps/s
+}
+
+struct result
+{
+    double seconds;
+    size_t ops;
+    size_t failures;
+};
+
+// every thread bump allocates `allocs` blocks of `size` bytes. chunk 0 is the shared CAS design
+result run(size_t threads, size_t chunk, size_t allocs, size_t size)
+{
+    // room for every allocation at max_align_t granularity, plus one partly used chunk per thread
+    const size_t padded = (size + alignof(std::max_align_t) - 1) & ~(alignof(std::max_align_t) - 1);
+    arena a(threads * (allocs * padded + 2 * chunk));
+    a.set_thread_chunk_size(chunk);
+
+    std::atomic<bool> start{false};
+    std::atomic<size_t> ready{0};
+    std::atomic<size_t> failures{0};
+    std::vector<std::thread> workers;
+    workers.reserve(threads);
+
+    for (size_t tid = 0; tid < threads; ++tid)
+    {
+        workers.emplace_back([&, tid] {
+            ready.fetch_add(1, std::memory_order_acq_rel);
+            wait_for_start(start);
+
+            for (size_t i = 0; i < allocs; ++i)
+            {
+                void* p = a.alloc(size);
+                if (p == nullptr)
+                    failures.fetch_add(1, std::memory_order_relaxed);
+                else
+                    *static_cast<unsigned char*>(p) = static_cast<unsigned char>(tid);
+            }
+        });
+    }
+
+    while (ready.load(std::memory_order_acquire) != threads)
+        std::this_thread::yield();
+
+    auto t0 = std::chrono::high_resolution_clock::now();
+    start.store(true, std::memory_order_release);
+    for (auto& t : workers)
+        t.join();
+    auto t1 = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> elapsed = t1 - t0;
+
+    return {elapsed.count(), threads * allocs, failures.load()};
+}
+} // namespace
+
+int main()
+{
+    constexpr std::array<size_t, 5> thread_counts = {1, 2, 4, 8, 16};
+    constexpr size_t allocs = 500000;
+    constexpr size_t chunk = 64 * 1024;
+
+    std::cout << "\n=== Arena Thread Scaling (shared CAS vs per-thread chunks) ===" << std::endl;
+    std::cout << "Hardware threads: " << std::thread::hardware_concurrency() << ", " << allocs << " allocs per thread, "
+              << chunk / 1024 << " KiB chunks\n"
+              << std::endl;
+
+    for (size_t size : {16, 64})
+    {
+        std::cout << "--- " << size << "B allocations ---" << std::endl;
+        for (size_t threads : thread_counts)
+        {
+            const result cas = run(threads, 0, allocs, size);
+            const result chunked = run(threads, chunk, allocs, size);
+
+            std::cout << "  " << threads << " threads | CAS: " << ns_per_op(cas.seconds, cas.ops) << " ns/op, "
+                      << throughput(cas.seconds, cas.ops) << " MOps/s"
+                      << " | chunks: " << ns_per_op(chunked.seconds, chunked.ops) << " ns/op, "
+                      << throughput(chunked.seconds, chunked.ops) << " MOps/s"
+                      << " | speedup: " << cas.seconds / chunked.seconds << "x" << std::endl;
+
+            if (cas.failures || chunked.failures)
+                std::cout << "  FAILED allocations: " << cas.failures + chunked.failures << std::endl;
+        }
+        std::cout << std::endl;
+    }
+
+    std::cout << "=== Thread scaling complete ===" << std::endl;
+    return 0;
+}
@@ -1,4 +1,5 @@
 #include "arena.h"
+#include "generational_arena.h"
 #include <algorithm>
 #include <atomic>
 #include <chrono>
@@ -129,9 +130,10 @@ int main()
     // Test 2: Exhaustion under contention
     // ========================================================================
     {
-        const size_t capacity_slots = threads * 5000;
+        // the arena rounds up to whole pages, so count the slots it really has
+        arena a(threads * 5000 * alloc_size);
+        const size_t capacity_slots = a.get_capacity() / alloc_size;
         const size_t attempts_per_thread = (capacity_slots / threads) + 2000;
-        arena a(capacity_slots * alloc_size);
 
         std::atomic<bool> start{false};
         std::atomic<size_t> successful_allocs{0};
@@ -274,6 +276,74 @@ int main()
                   << std::endl;
     }
 
+    // ========================================================================
+    // Test 4: Same work with reset running concurrently (generational_arena)
+    // ========================================================================
+    {
+        const size_t cycles = 75;
+        const size_t allocs_per_thread_per_cycle = 500;
+        const size_t cycle_bytes = threads * allocs_per_thread_per_cycle * alloc_size;
+        generational_arena a(cycle_bytes * 2);
+
+        std::atomic<bool> start{false};
+        std::atomic<size_t> finished{0};
+        std::atomic<size_t> full_waits{0};
+        std::vector<std::thread> workers;
+        workers.reserve(threads);
+
+        auto begin = std::chrono::high_resolution_clock::now();
+
+        for (size_t tid = 0; tid < threads; ++tid)
+        {
+            workers.emplace_back([&, tid] {
+                wait_for_start(start);
+                for (size_t i = 0; i < cycles * allocs_per_thread_per_cycle; ++i)
+                {
+                    void* ptr = a.alloc(alloc_size);
+                    // the generation filled up before the resetter got to it
+                    while (ptr == nullptr)
+                    {
+                        full_waits.fetch_add(1, std::memory_order_relaxed);
+                        std::this_thread::yield();
+                        ptr = a.alloc(alloc_size);
+                    }
+                    std::memset(ptr, static_cast<int>((tid + i) & 0xFF), alloc_size);
+                }
+                finished.fetch_add(1, std::memory_order_release);
+            });
+        }
+
+        // no worker is stopped: a reset only publishes the next generation
+        start.store(true, std::memory_order_release);
+        size_t resets = 0;
+        while (finished.load(std::memory_order_acquire) != threads)
+        {
+            if (a.get_used() >= cycle_bytes)
+            {
+                if (a.reset() != 0)
+                {
+                    std::cerr << "ERROR: Concurrent reset failed" << std::endl;
+                    return 1;
+                }
+                ++resets;
+            }
+            std::this_thread::yield();
+        }
+        for (auto& t : workers)
+            t.join();
+
+        auto end = std::chrono::high_resolution_clock::now();
+        std::chrono::duration<double> elapsed = end - begin;
+
+        std::cout << "--- Test 4: Concurrent cycles + concurrent reset (generational_arena) ---\n"
+                  << "Allocations:       " << threads * cycles * allocs_per_thread_per_cycle << '\n'
+                  << "Resets:            " << resets << '\n'
+                  << "Full waits:        " << full_waits.load() << '\n'
+                  << "Elapsed:           " << elapsed.count() << " s\n"
+                  << "[PASSED]\n"
+                  << std::endl;
+    }
+
     std::cout << "========================================" << std::endl;
     std::cout << "[PASSED] All arena threaded stress tests passed!" << std::endl;
     std::cout << "========================================\n" << std::endl;
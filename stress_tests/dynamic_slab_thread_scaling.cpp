@@ -0,0 +1,133 @@
+#include "dynamic_slab.h"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+using namespace AL;
+
+namespace
+{
+void wait_for_start(const std::atomic<bool>& start)
+{
+    while (!start.load(std::memory_order_acquire))
+        std::this_thread::yield();
+}
+
+double ns_per_op(double elapsed_s, size_t ops)
+{
+    return (elapsed_s * 1e9) / static_cast<double>(ops);
+}
+
+double throughput(double elapsed_s, size_t ops)
+{
+    return static_cast<double>(ops) / elapsed_s / 1e6; // MOps/s
+}
+
+struct result
+{
+    double seconds;
+    size_t ops;
+    size_t nodes;
+    size_t failures;
+};
+
+// every thread holds `hold` blocks of one size, frees them, and repeats
+result run(size_t threads, size_t home_nodes, size_t hold, size_t size)
+{
+    constexpr size_t rounds = 200;
+
+    dynamic_slab ds(1);
+    ds.set_home_nodes(home_nodes);
+
+    std::atomic<bool> start{false};
+    std::atomic<size_t> ready{0};
+    std::atomic<size_t> failures{0};
+    std::vector<std::thread> workers;
+    workers.reserve(threads);
+
+    for (size_t tid = 0; tid < threads; ++tid)
+    {
+        workers.emplace_back([&, tid] {
+            std::vector<void*> ptrs(hold);
+            // round 0 is an untimed warm up, so mapping home nodes is not measured
+            for (size_t r = 0; r <= rounds; ++r)
+            {
+                if (r == 1)
+                {
+                    ready.fetch_add(1, std::memory_order_acq_rel);
+                    wait_for_start(start);
+                }
+
+                for (auto& p : ptrs)
+                {
+                    p = ds.palloc(size);
+                    if (p == nullptr)
+                        failures.fetch_add(1, std::memory_order_relaxed);
+                    else
+                        std::memset(p, static_cast<int>(tid & 0xFF), 8);
+                }
+                for (void* p : ptrs)
+                    ds.free(p, size);
+            }
+        });
+    }
+
+    while (ready.load(std::memory_order_acquire) != threads)
+        std::this_thread::yield();
+
+    auto t0 = std::chrono::high_resolution_clock::now();
+    start.store(true, std::memory_order_release);
+    for (auto& t : workers)
+        t.join();
+    auto t1 = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> elapsed = t1 - t0;
+
+    return {elapsed.count(), threads * rounds * hold * 2, ds.get_slab_count(), failures.load()};
+}
+} // namespace
+
+int main()
+{
+    constexpr std::array<size_t, 3> thread_counts = {8, 16, 32};
+
+    std::cout << "\n=== Dynamic Slab Thread Scaling (home nodes) ===" << std::endl;
+    std::cout << "Hardware threads: " << std::thread::hardware_concurrency() << '\n' << std::endl;
+
+    struct workload
+    {
+        const char* name;
+        size_t hold;
+        size_t size;
+    };
+    constexpr std::array<workload, 2> workloads = {{
+        {"hold 32 x 64B (fits the TLC)", 32, 64},
+        {"hold 500 x 32B (spills the TLC)", 500, 32},
+    }};
+
+    for (const workload& w : workloads)
+    {
+        std::cout << "--- " << w.name << " ---" << std::endl;
+        for (size_t threads : thread_counts)
+        {
+            const result shared = run(threads, 0, w.hold, w.size);
+            const result homed = run(threads, threads, w.hold, w.size);
+
+            std::cout << "  " << threads << " threads | shared: " << ns_per_op(shared.seconds, shared.ops) << " ns/op, "
+                      << throughput(shared.seconds, shared.ops) << " MOps/s, " << shared.nodes << " nodes"
+                      << " | home nodes: " << ns_per_op(homed.seconds, homed.ops) << " ns/op, " << throughput(homed.seconds, homed.ops)
+                      << " MOps/s, " << homed.nodes << " nodes" << std::endl;
+
+            if (shared.failures || homed.failures)
+                std::cout << "  FAILED allocations: " << shared.failures + homed.failures << std::endl;
+        }
+        std::cout << std::endl;
+    }
+
+    std::cout << "=== Thread scaling complete ===" << std::endl;
+    return 0;
+}
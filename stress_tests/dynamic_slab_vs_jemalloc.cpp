@@ -177,6 +177,58 @@ int main()
         std::cout << "\n";
     }
 
+    // Test 4: growth policy. hold ~100x the first node's capacity, then cycle through it
+    {
+        std::cout << "--- Test 4: Growth policy (single-threaded, hold 12800 x 128B, then free) ---\n";
+        constexpr size_t hold = 12800;
+        constexpr size_t cycles = 50;
+        constexpr size_t sz = 128;
+
+        std::vector<void*> ptrs(hold);
+
+        auto run_growth = [&](const char* label, const dynamic_slab_growth& growth) {
+            dynamic_slab ds(1, growth);
+            // the first pass pays for mapping, later passes for reaching a node with room
+            auto t0 = std::chrono::high_resolution_clock::now();
+            for (size_t i = 0; i < hold; ++i)
+                ptrs[i] = ds.palloc(sz);
+            auto t1 = std::chrono::high_resolution_clock::now();
+            for (size_t i = 0; i < hold; ++i)
+                ds.free(ptrs[i], sz);
+
+            auto t2 = std::chrono::high_resolution_clock::now();
+            for (size_t c = 0; c < cycles; ++c)
+            {
+                for (size_t i = 0; i < hold; ++i)
+                    ptrs[i] = ds.palloc(sz);
+                for (size_t i = 0; i < hold; ++i)
+                    ds.free(ptrs[i], sz);
+            }
+            auto t3 = std::chrono::high_resolution_clock::now();
+            std::chrono::duration<double> grow_time = t1 - t0;
+            std::chrono::duration<double> steady_time = t3 - t2;
+            std::cout << "  " << label << ": " << ds.get_slab_count() << " nodes | first fill " << ns_per_op(grow_time.count(), hold)
+                      << " ns/alloc | steady " << ns_per_op(steady_time.count(), cycles * hold * 2) << " ns/op\n";
+        };
+
+        run_growth("Flat (factor 1)    ", {});
+        run_growth("Geometric (x2, <=64)", {.factor = 2, .max_scale = 64});
+        run_growth("Reserved (4 nodes)  ", {.factor = 2, .max_scale = 64, .reserve_nodes = 4});
+
+        // jemalloc
+        auto t0 = std::chrono::high_resolution_clock::now();
+        for (size_t c = 0; c < cycles; ++c)
+        {
+            for (size_t i = 0; i < hold; ++i)
+                ptrs[i] = mallocx(sz, 0);
+            for (size_t i = 0; i < hold; ++i)
+                dallocx(ptrs[i], 0);
+        }
+        auto t1 = std::chrono::high_resolution_clock::now();
+        std::chrono::duration<double> je_time = t1 - t0;
+        std::cout << "  jemalloc:              steady " << ns_per_op(je_time.count(), cycles * hold * 2) << " ns/op\n\n";
+    }
+
     std::cout << "=== Unbounded allocation comparison complete ===\n";
     return 0;
 }
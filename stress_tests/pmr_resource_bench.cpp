@@ -0,0 +1,147 @@
+#include "arena.h"
+#include "dynamic_slab.h"
+#include "memory_resource.h"
+#include "pool.h"
+#include "slab.h"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <list>
+#include <memory_resource>
+#include <string>
+#include <vector>
+
+using namespace AL;
+
+namespace
+{
+constexpr size_t rounds = 2000;
+constexpr size_t elements = 1000;
+
+// push_back growth: every reallocation frees the previous, smaller buffer.
+// 4 byte elements keep the last buffer within slab's largest size class
+uint64_t vector_growth(std::pmr::memory_resource* r)
+{
+    std::pmr::vector<uint32_t> v(r);
+    for (size_t i = 0; i < elements; ++i)
+        v.push_back(static_cast<uint32_t>(i));
+    return v.back();
+}
+
+// node churn: fill a list, then erase and re-insert every other node
+uint64_t list_churn(std::pmr::memory_resource* r)
+{
+    std::pmr::list<uint64_t> l(r);
+    for (size_t i = 0; i < elements; ++i)
+        l.push_back(i);
+    for (auto it = l.begin(); it != l.end();)
+    {
+        it = l.erase(it);
+        if (it != l.end())
+            ++it;
+    }
+    for (size_t i = 0; i < elements / 2; ++i)
+        l.push_front(i);
+    return l.size();
+}
+
+template<typename F>
+double ns_per_round(F work, std::pmr::memory_resource* r, uint64_t& sink)
+{
+    auto begin = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < rounds; ++i)
+        sink += work(r);
+    auto end = std::chrono::high_resolution_clock::now();
+
+    std::chrono::duration<double> elapsed = end - begin;
+    return elapsed.count() * 1e9 / static_cast<double>(rounds);
+}
+
+void print_row(const std::string& name, double vector_ns, double list_ns)
+{
+    std::cout.width(32);
+    std::cout << std::left << name;
+    std::cout.width(16);
+    std::cout << std::left << vector_ns;
+    std::cout << list_ns << std::endl;
+}
+} // namespace
+
+int main()
+{
+    uint64_t sink = 0;
+
+    std::cout << "\n=== std::pmr Resources ===" << std::endl;
+    std::cout << rounds << " rounds of " << elements << " elements, ns per round\n" << std::endl;
+    std::cout << "resource                        vector growth   list churn\n";
+
+    {
+        std::pmr::memory_resource* r = std::pmr::new_delete_resource();
+        print_row("new_delete_resource", ns_per_round(vector_growth, r, sink), ns_per_round(list_churn, r, sink));
+    }
+    {
+        // the buffer is only released when the resource is, so each round gets a fresh one
+        auto vector_ns = ns_per_round(
+            [](std::pmr::memory_resource*) {
+                std::pmr::monotonic_buffer_resource r;
+                return vector_growth(&r);
+            },
+            nullptr, sink);
+        auto list_ns = ns_per_round(
+            [](std::pmr::memory_resource*) {
+                std::pmr::monotonic_buffer_resource r;
+                return list_churn(&r);
+            },
+            nullptr, sink);
+        print_row("monotonic_buffer_resource", vector_ns, list_ns);
+    }
+    {
+        std::pmr::unsynchronized_pool_resource r;
+        print_row("unsynchronized_pool_resource", ns_per_round(vector_growth, &r, sink),
+                  ns_per_round(list_churn, &r, sink));
+    }
+    {
+        // like the monotonic buffer, the arena is reset between rounds
+        arena a(1 << 20);
+        arena_resource r(&a);
+        auto vector_ns = ns_per_round(
+            [&a](std::pmr::memory_resource* res) {
+                a.reset();
+                return vector_growth(res);
+            },
+            &r, sink);
+        auto list_ns = ns_per_round(
+            [&a](std::pmr::memory_resource* res) {
+                a.reset();
+                return list_churn(res);
+            },
+            &r, sink);
+        print_row("arena_resource", vector_ns, list_ns);
+    }
+    {
+        // scale 4 gives the 32 byte class room for every list node
+        slab s(4);
+        slab_resource r(&s);
+        print_row("slab_resource", ns_per_round(vector_growth, &r, sink), ns_per_round(list_churn, &r, sink));
+    }
+    {
+        dynamic_slab s;
+        dynamic_slab_resource r(&s);
+        print_row("dynamic_slab_resource", ns_per_round(vector_growth, &r, sink), ns_per_round(list_churn, &r, sink));
+    }
+    {
+        // list nodes only, a pool has a single block size
+        pool p(32, elements);
+        pool_resource r(&p);
+        auto list_ns = ns_per_round(list_churn, &r, sink);
+        std::cout.width(32);
+        std::cout << std::left << "pool_resource (32 byte blocks)";
+        std::cout.width(16);
+        std::cout << std::left << "-";
+        std::cout << list_ns << std::endl;
+    }
+
+    std::cout << "\n(checksum " << sink << ")\n" << std::endl;
+    return 0;
+}
@@ -0,0 +1,129 @@
+#include "arena.h"
+#include "scratch.h"
+#include <alloca.h>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+using namespace AL;
+
+namespace
+{
+// every call takes three scratch buffers of `size` bytes, touches them and returns a checksum
+constexpr size_t buffers_per_call = 3;
+
+uint64_t touch(unsigned char* p, size_t size, size_t i)
+{
+    p[0] = static_cast<unsigned char>(i);
+    p[size - 1] = static_cast<unsigned char>(i >> 8);
+    return p[0] + p[size / 2] + p[size - 1];
+}
+
+[[gnu::noinline]] uint64_t call_scratch(size_t size, size_t i)
+{
+    scratch_scope s;
+    uint64_t sum = 0;
+    for (size_t b = 0; b < buffers_per_call; ++b)
+    {
+        auto* p = static_cast<unsigned char*>(s.alloc(size));
+        if (p == nullptr)
+            std::abort();
+        sum += touch(p, size, i);
+    }
+    return sum;
+}
+
+[[gnu::noinline]] uint64_t call_alloca(size_t size, size_t i)
+{
+    uint64_t sum = 0;
+    for (size_t b = 0; b < buffers_per_call; ++b)
+    {
+        auto* p = static_cast<unsigned char*>(alloca(size));
+        sum += touch(p, size, i);
+    }
+    return sum;
+}
+
+[[gnu::noinline]] uint64_t call_malloc(size_t size, size_t i)
+{
+    std::array<unsigned char*, buffers_per_call> ptrs;
+    uint64_t sum = 0;
+    for (size_t b = 0; b < buffers_per_call; ++b)
+    {
+        ptrs[b] = static_cast<unsigned char*>(std::malloc(size));
+        if (ptrs[b] == nullptr)
+            std::abort();
+        sum += touch(ptrs[b], size, i);
+    }
+    for (unsigned char* p : ptrs)
+        std::free(p);
+    return sum;
+}
+
+// what the scratch scope replaces: a private arena, so an mmap and munmap per call
+[[gnu::noinline]] uint64_t call_arena(size_t size, size_t i)
+{
+    arena a(buffers_per_call * size);
+    uint64_t sum = 0;
+    for (size_t b = 0; b < buffers_per_call; ++b)
+    {
+        auto* p = static_cast<unsigned char*>(a.alloc(size, 1));
+        if (p == nullptr)
+            std::abort();
+        sum += touch(p, size, i);
+    }
+    return sum;
+}
+
+template<typename F>
+double ns_per_call(F call, size_t size, size_t calls, uint64_t& sink)
+{
+    // warm up: maps the scratch region, faults the stack and primes malloc
+    for (size_t i = 0; i < 1000 && i < calls; ++i)
+        sink += call(size, i);
+
+    auto begin = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < calls; ++i)
+        sink += call(size, i);
+    auto end = std::chrono::high_resolution_clock::now();
+
+    std::chrono::duration<double> elapsed = end - begin;
+    return elapsed.count() * 1e9 / static_cast<double>(calls);
+}
+} // namespace
+
+int main()
+{
+    const std::array<size_t, 4> sizes = {64, 1024, 16 * 1024, 256 * 1024};
+    const size_t calls = 2000000;
+    const size_t arena_calls = 50000;
+    uint64_t sink = 0;
+
+    std::cout << "\n=== Scratch Scope vs alloca / malloc ===" << std::endl;
+    std::cout << "Each call takes " << buffers_per_call << " buffers of the given size and touches them\n" << std::endl;
+    std::cout << "size        scratch ns   alloca ns    malloc ns    arena ns (mmap per call)\n";
+
+    for (size_t size : sizes)
+    {
+        const double scratch_ns = ns_per_call(call_scratch, size, calls, sink);
+        const double alloca_ns = ns_per_call(call_alloca, size, calls, sink);
+        const double malloc_ns = ns_per_call(call_malloc, size, calls, sink);
+        const double arena_ns = ns_per_call(call_arena, size, arena_calls, sink);
+
+        std::cout.width(12);
+        std::cout << std::left << size;
+        for (double ns : {scratch_ns, alloca_ns, malloc_ns, arena_ns})
+        {
+            std::cout.width(13);
+            std::cout << std::left << ns;
+        }
+        std::cout << '\n';
+    }
+
+    std::cout << "\n(checksum " << sink << ")\n" << std::endl;
+    return 0;
+}
@@ -1,3 +1,4 @@
+#include "profiler.h"
 #include "slab.h"
 #include <algorithm>
 #include <atomic>
@@ -255,6 +256,42 @@ int main()
             delete sp;
     }
 
+    // Test 6: Heap profiler overhead on the TLC fast path
+    // Same churn as Test 1 at 64B with the profiler compiled in: sampling off, then sampling on.
+    // With sampling on nearly every op still takes the unsampled path (one thread-local subtraction).
+    {
+        std::cout << "--- Test 6: Heap profiler overhead (64B alloc+free) ---\n";
+        if constexpr (!profiling_enabled)
+        {
+            std::cout << "  [skipped] build with -DPALLOC_ENABLE_PROFILING=ON (build.py --heap-profile)\n\n";
+        }
+        else
+        {
+            constexpr size_t ops = 2'000'000;
+            slab s(4.0);
+
+            auto bench = [&](size_t rate, const char* label) {
+                heap_profiler::set_sample_rate(rate);
+                auto t0 = std::chrono::high_resolution_clock::now();
+                for (size_t i = 0; i < ops; ++i)
+                {
+                    void* p = s.alloc(64);
+                    s.free(p, 64);
+                }
+                auto t1 = std::chrono::high_resolution_clock::now();
+                std::chrono::duration<double> elapsed = t1 - t0;
+                std::cout << "  " << label << ": " << ns_per_op(elapsed.count(), ops * 2) << " ns/op\n";
+            };
+
+            bench(0, "sampling off      ");
+            bench(512 * 1024, "sampling 512 KiB  ");
+            bench(64 * 1024, "sampling  64 KiB  ");
+            heap_profiler::set_sample_rate(0);
+            heap_profiler::clear();
+            std::cout << "\n";
+        }
+    }
+
     std::cout << "=================================================\n";
     std::cout << "[PASSED] All TLC stress tests passed!\n";
     std::cout << "=================================================\n\n";
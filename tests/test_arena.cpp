@@ -1,8 +1,10 @@
 #include "arena.h"
 #include <catch2/catch_test_macros.hpp>
 #include <cstddef>
+#include <cstdint>
 #include <cstring>
 #include <unistd.h>
+#include <utility>
 #include <vector>
 
 const size_t PAGE_SIZE = getpagesize();
@@ -324,3 +326,660 @@ TEST_CASE("Arena: Capacity rounding", "[arena][capacity]")
     }
 }
 
+TEST_CASE("Arena: Stats snapshot", "[arena][stats]")
+{
+    AL::arena a(PAGE_SIZE);
+
+    void* p = a.alloc(64);
+    REQUIRE(p != nullptr);
+    REQUIRE(a.alloc(PAGE_SIZE) == nullptr);
+
+    AL::arena_stats st = a.stats();
+    REQUIRE(st.used == a.get_used());
+    REQUIRE(st.capacity == a.get_capacity());
+
+    a.reset();
+    if constexpr (AL::stats_enabled)
+    {
+        REQUIRE(st.failed_allocs == 1);
+        REQUIRE(a.stats().resets == 1);
+    }
+}
+
+TEST_CASE("Arena: Thread chunks", "[arena][chunks]")
+{
+    AL::arena a(PAGE_SIZE * 4);
+    a.set_thread_chunk_size(1024);
+
+    SECTION("Allocations bump inside one reserved chunk")
+    {
+        void* p1 = a.alloc(16);
+        void* p2 = a.alloc(24);
+        void* p3 = a.alloc(8);
+        REQUIRE(p1 != nullptr);
+        REQUIRE(p2 != nullptr);
+        REQUIRE(p3 != nullptr);
+        REQUIRE(static_cast<std::byte*>(p2) == static_cast<std::byte*>(p1) + 16);
+        REQUIRE(reinterpret_cast<uintptr_t>(p3) % alignof(std::max_align_t) == 0);
+
+        // the whole chunk is reserved up front
+        REQUIRE(a.get_used() == 1024);
+        if constexpr (AL::stats_enabled)
+            REQUIRE(a.stats().chunk_refills == 1);
+    }
+
+    SECTION("Exhausted chunks are replaced and the tail of the arena stays usable")
+    {
+        size_t count = 0;
+        while (a.alloc(100) != nullptr)
+            count++;
+
+        // 9 x 112 bytes per chunk, 4 chunks per page
+        REQUIRE(count >= 4 * 4 * 9);
+        REQUIRE(a.get_used() <= a.get_capacity());
+    }
+
+    SECTION("Allocations larger than a chunk use the shared offset")
+    {
+        void* small = a.alloc(16);
+        void* large = a.alloc(2048);
+        REQUIRE(small != nullptr);
+        REQUIRE(large != nullptr);
+        REQUIRE(a.get_used() == 1024 + 2048);
+    }
+
+    SECTION("Reset retires the chunk")
+    {
+        void* p1 = a.alloc(16);
+        a.reset();
+        REQUIRE(a.get_used() == 0);
+
+        // the old chunk is not bumped further, a new one starts at the beginning again
+        void* p2 = a.alloc(16);
+        REQUIRE(p2 == p1);
+        REQUIRE(a.get_used() == 1024);
+    }
+
+    SECTION("An arena moved into keeps no stale chunk")
+    {
+        REQUIRE(a.alloc(16) != nullptr);
+        AL::arena b(PAGE_SIZE);
+        b = std::move(a);
+        REQUIRE(b.get_used() == 1024);
+
+        void* p = b.alloc(16);
+        REQUIRE(p != nullptr);
+        REQUIRE(b.get_used() == 2048);
+    }
+}
+
+TEST_CASE("Arena: Caller-specified alignment", "[arena][alignment]")
+{
+    AL::arena a(PAGE_SIZE * 4);
+
+    SECTION("Small alignments pack tightly")
+    {
+        void* p1 = a.alloc(3, 1);
+        void* p2 = a.alloc(1, 1);
+        void* p3 = a.alloc(4, 4);
+        REQUIRE(static_cast<std::byte*>(p2) == static_cast<std::byte*>(p1) + 3);
+        REQUIRE(static_cast<std::byte*>(p3) == static_cast<std::byte*>(p1) + 4);
+        REQUIRE(a.get_used() == 8);
+    }
+
+    SECTION("The default keeps max_align_t alignment")
+    {
+        REQUIRE(a.alloc(1) != nullptr);
+        void* p = a.alloc(1);
+        REQUIRE(reinterpret_cast<uintptr_t>(p) % alignof(std::max_align_t) == 0);
+        REQUIRE(a.get_used() == alignof(std::max_align_t) + 1);
+    }
+
+    SECTION("Cache line and page alignment")
+    {
+        REQUIRE(a.alloc(1, 1) != nullptr);
+        void* line = a.alloc(64, 64);
+        REQUIRE(reinterpret_cast<uintptr_t>(line) % 64 == 0);
+
+        void* page = a.alloc(100, PAGE_SIZE);
+        REQUIRE(page != nullptr);
+        REQUIRE(reinterpret_cast<uintptr_t>(page) % PAGE_SIZE == 0);
+
+        // a larger alignment than the mapping guarantees is resolved from the address
+        void* big = a.alloc(16, PAGE_SIZE * 2);
+        if (big != nullptr)
+            REQUIRE(reinterpret_cast<uintptr_t>(big) % (PAGE_SIZE * 2) == 0);
+    }
+
+    SECTION("Alignment that is not a power of two fails")
+    {
+        REQUIRE(a.alloc(16, 0) == nullptr);
+        REQUIRE(a.alloc(16, 24) == nullptr);
+        REQUIRE(a.get_used() == 0);
+    }
+
+    SECTION("Thread chunks honour alignment")
+    {
+        a.set_thread_chunk_size(1024);
+        void* p1 = a.alloc(3, 1);
+        void* p2 = a.alloc(8, 8);
+        void* p3 = a.alloc(64, 64);
+        REQUIRE(static_cast<std::byte*>(p2) == static_cast<std::byte*>(p1) + 8);
+        REQUIRE(reinterpret_cast<uintptr_t>(p3) % 64 == 0);
+
+        // padding that cannot fit in a chunk goes to the shared offset
+        void* page = a.alloc(512, PAGE_SIZE);
+        REQUIRE(page != nullptr);
+        REQUIRE(reinterpret_cast<uintptr_t>(page) % PAGE_SIZE == 0);
+    }
+}
+
+TEST_CASE("Arena: Savepoints", "[arena][rollback]")
+{
+    AL::arena a(PAGE_SIZE * 4);
+
+    SECTION("Rollback frees what came after the marker and keeps what came before")
+    {
+        auto* kept = static_cast<char*>(a.alloc(64));
+        std::memset(kept, 'k', 64);
+
+        const AL::arena::marker m = a.mark();
+        void* scratch = a.alloc(512);
+        REQUIRE(scratch != nullptr);
+        REQUIRE(a.rollback(m) == 0);
+        REQUIRE(a.get_used() == m.offset);
+
+        // the scratch space is handed out again
+        REQUIRE(a.alloc(512) == scratch);
+        for (size_t i = 0; i < 64; ++i)
+            REQUIRE(kept[i] == 'k');
+    }
+
+    SECTION("Nested scopes unwind innermost first")
+    {
+        REQUIRE(a.alloc(32) != nullptr);
+        const size_t before = a.get_used();
+        {
+            AL::arena::scope outer(a);
+            REQUIRE(a.alloc(100) != nullptr);
+            const size_t middle = a.get_used();
+            {
+                AL::arena::scope inner(a);
+                REQUIRE(a.alloc(1000) != nullptr);
+                REQUIRE(a.alloc(1000) != nullptr);
+            }
+            REQUIRE(a.get_used() == middle);
+        }
+        REQUIRE(a.get_used() == before);
+        if constexpr (AL::stats_enabled)
+            REQUIRE(a.stats().rollbacks == 2);
+    }
+
+    SECTION("An outer marker that was already rolled back past is rejected")
+    {
+        REQUIRE(a.alloc(16) != nullptr);
+        const AL::arena::marker inner_first = a.mark();
+        REQUIRE(a.alloc(16) != nullptr);
+        const AL::arena::marker later = a.mark();
+
+        REQUIRE(a.rollback(inner_first) == 0);
+        REQUIRE(a.rollback(later) == -1);
+        REQUIRE(a.get_used() == inner_first.offset);
+    }
+
+    SECTION("Rollback retires thread chunks")
+    {
+        a.set_thread_chunk_size(1024);
+        const AL::arena::marker m = a.mark();
+        void* p = a.alloc(16);
+        REQUIRE(a.rollback(m) == 0);
+        REQUIRE(a.get_used() == 0);
+
+        // a new chunk starts at the marker instead of bumping the old one
+        REQUIRE(a.alloc(16) == p);
+        REQUIRE(a.get_used() == 1024);
+    }
+}
+
+TEST_CASE("Arena: Releasing memory on reset", "[arena][reset][resident]")
+{
+    AL::arena a(PAGE_SIZE * 64);
+
+    auto touch = [&](size_t bytes) {
+        void* p = a.alloc(bytes);
+        REQUIRE(p != nullptr);
+        std::memset(p, 1, bytes);
+    };
+
+    SECTION("By default every touched page stays resident")
+    {
+        touch(PAGE_SIZE * 32);
+        REQUIRE(a.get_resident() >= PAGE_SIZE * 32);
+        a.reset();
+        REQUIRE(a.get_resident() >= PAGE_SIZE * 32);
+    }
+
+    SECTION("Pages above the retained size are purged")
+    {
+        a.set_retained_bytes(PAGE_SIZE * 4);
+        touch(PAGE_SIZE * 32);
+        REQUIRE(a.reset() == 0);
+        REQUIRE(a.get_resident() <= PAGE_SIZE * 4);
+        if constexpr (AL::stats_enabled)
+            REQUIRE(a.stats().purged_bytes == PAGE_SIZE * 28);
+
+        // purged pages are still usable and read back as zeros
+        auto* p = static_cast<unsigned char*>(a.alloc(PAGE_SIZE * 32));
+        REQUIRE(p != nullptr);
+        REQUIRE(p[PAGE_SIZE * 31] == 0);
+        REQUIRE(p[0] == 1);
+    }
+
+    SECTION("Pages the top end touched are purged too")
+    {
+        a.set_retained_bytes(PAGE_SIZE * 4);
+        void* p = a.alloc_top(PAGE_SIZE * 48);
+        REQUIRE(p != nullptr);
+        std::memset(p, 1, PAGE_SIZE * 48);
+        a.reset_top();
+        REQUIRE(a.get_resident() >= PAGE_SIZE * 48);
+
+        REQUIRE(a.reset() == 0);
+        REQUIRE(a.get_resident() <= PAGE_SIZE * 4);
+    }
+
+    SECTION("The high-water mark forgets an outlier over a few resets")
+    {
+        a.set_high_water_decay(50);
+        touch(PAGE_SIZE * 2);
+        a.reset();
+
+        touch(PAGE_SIZE * 48);
+        a.reset();
+        // the outlier is the mark for now
+        REQUIRE(a.get_resident() >= PAGE_SIZE * 48);
+
+        for (int i = 0; i < 8; ++i)
+        {
+            touch(PAGE_SIZE * 2);
+            a.reset();
+        }
+        REQUIRE(a.get_resident() <= PAGE_SIZE * 4);
+    }
+
+    SECTION("Memory rewound by rollback counts towards the cycle's peak")
+    {
+        a.set_high_water_decay(100);
+        {
+            AL::arena::scope s(a);
+            touch(PAGE_SIZE * 16);
+        }
+        a.reset();
+        REQUIRE(a.get_resident() >= PAGE_SIZE * 16);
+        a.reset();
+        REQUIRE(a.get_resident() == 0);
+    }
+}
+
+namespace
+{
+// appends its id to a shared log when destroyed
+struct tracked
+{
+    std::vector<int>* log;
+    int id;
+
+    tracked(std::vector<int>* l, int i) : log(l), id(i)
+    {}
+
+    ~tracked()
+    {
+        log->push_back(id);
+    }
+};
+
+struct counted
+{
+    static inline int destroyed = 0;
+
+    ~counted()
+    {
+        ++destroyed;
+    }
+};
+
+struct throws_on_third
+{
+    static inline int constructed = 0;
+    static inline int destroyed = 0;
+
+    throws_on_third()
+    {
+        if (constructed == 2)
+            throw 42;
+        ++constructed;
+    }
+
+    ~throws_on_third()
+    {
+        ++destroyed;
+    }
+};
+} // namespace
+
+TEST_CASE("Arena: Typed construction", "[arena][make]")
+{
+    AL::arena a(PAGE_SIZE * 4);
+    std::vector<int> log;
+
+    SECTION("Trivially destructible types take no more than alloc()")
+    {
+        auto* p = a.make<uint64_t>(uint64_t{7});
+        REQUIRE(p != nullptr);
+        REQUIRE(*p == 7);
+        REQUIRE(a.get_used() == sizeof(uint64_t));
+
+        auto* arr = a.make_array<int>(10);
+        REQUIRE(arr != nullptr);
+        for (size_t i = 0; i < 10; ++i)
+            REQUIRE(arr[i] == 0);
+    }
+
+    SECTION("Destructors run in reverse order on reset")
+    {
+        for (int i = 0; i < 5; ++i)
+        {
+            tracked* t = a.make<tracked>(&log, i);
+            REQUIRE(t != nullptr);
+            REQUIRE(reinterpret_cast<uintptr_t>(t) % alignof(tracked) == 0);
+        }
+        REQUIRE(log.empty());
+
+        REQUIRE(a.reset() == 0);
+        REQUIRE(log == std::vector<int>{4, 3, 2, 1, 0});
+
+        // nothing runs twice
+        REQUIRE(a.reset() == 0);
+        REQUIRE(log.size() == 5);
+    }
+
+    SECTION("Destructors run when the arena is destroyed")
+    {
+        {
+            AL::arena b(PAGE_SIZE);
+            REQUIRE(b.make<tracked>(&log, 1) != nullptr);
+            REQUIRE(b.make<tracked>(&log, 2) != nullptr);
+        }
+        REQUIRE(log == std::vector<int>{2, 1});
+    }
+
+    SECTION("Arrays destroy every element, last one first")
+    {
+        counted::destroyed = 0;
+
+        REQUIRE(a.make_array<counted>(100) != nullptr);
+        REQUIRE(a.make_array<counted>(0) == nullptr);
+        REQUIRE(a.clear() == 0);
+        REQUIRE(counted::destroyed == 100);
+    }
+
+    SECTION("A throwing element constructor destroys the elements before it and leaves no record")
+    {
+        throws_on_third::constructed = 0;
+        throws_on_third::destroyed = 0;
+        REQUIRE_THROWS(a.make_array<throws_on_third>(5));
+        REQUIRE(throws_on_third::destroyed == 2);
+
+        REQUIRE(a.reset() == 0);
+        REQUIRE(throws_on_third::destroyed == 2);
+    }
+
+    SECTION("Rollback destroys only the objects past the marker")
+    {
+        REQUIRE(a.make<tracked>(&log, 1) != nullptr);
+        {
+            AL::arena::scope s(a);
+            REQUIRE(a.make<tracked>(&log, 2) != nullptr);
+            REQUIRE(a.make<tracked>(&log, 3) != nullptr);
+        }
+        REQUIRE(log == std::vector<int>{3, 2});
+
+        REQUIRE(a.reset() == 0);
+        REQUIRE(log == std::vector<int>{3, 2, 1});
+    }
+
+    SECTION("Moving the arena moves the destructors with it")
+    {
+        REQUIRE(a.make<tracked>(&log, 1) != nullptr);
+        AL::arena b(std::move(a));
+        REQUIRE(log.empty());
+
+        REQUIRE(b.reset() == 0);
+        REQUIRE(log == std::vector<int>{1});
+    }
+
+    SECTION("A full arena returns nullptr without constructing")
+    {
+        AL::arena small(PAGE_SIZE);
+        REQUIRE(small.make_array<counted>(PAGE_SIZE) == nullptr);
+        REQUIRE(small.make_array<uint64_t>(static_cast<size_t>(-1) / 4) == nullptr);
+    }
+}
+
+TEST_CASE("Arena: Double-ended allocation", "[arena][top]")
+{
+    AL::arena a(PAGE_SIZE);
+    const size_t cap = a.get_capacity();
+
+    SECTION("Top allocations come down from the end of the mapping")
+    {
+        auto* t1 = static_cast<std::byte*>(a.alloc_top(64));
+        auto* t2 = static_cast<std::byte*>(a.alloc_top(64));
+        auto* b1 = static_cast<std::byte*>(a.alloc(64));
+        REQUIRE(t1 != nullptr);
+        REQUIRE(t2 == t1 - 64);
+        REQUIRE(b1 + cap - 64 == t1);
+        REQUIRE(a.get_used_top() == 128);
+        REQUIRE(a.get_used() == 64);
+
+        void* aligned = a.alloc_top(10, 256);
+        REQUIRE(reinterpret_cast<uintptr_t>(aligned) % 256 == 0);
+        REQUIRE(a.alloc_top(8, 3) == nullptr);
+    }
+
+    SECTION("Both ends share one capacity")
+    {
+        REQUIRE(a.alloc(cap / 2) != nullptr);
+        REQUIRE(a.alloc_top(cap / 2) != nullptr);
+        REQUIRE(a.alloc(1, 1) == nullptr);
+        REQUIRE(a.alloc_top(1, 1) == nullptr);
+        REQUIRE(a.get_used() + a.get_used_top() == cap);
+    }
+
+    SECTION("reset_top() frees only the temporaries")
+    {
+        auto* persistent = static_cast<unsigned char*>(a.alloc(cap / 2));
+        std::memset(persistent, 0x5a, cap / 2);
+        REQUIRE(a.alloc_top(cap / 2) != nullptr);
+        REQUIRE(a.alloc_top(16) == nullptr);
+
+        a.reset_top();
+        REQUIRE(a.get_used_top() == 0);
+        REQUIRE(a.get_used() == cap / 2);
+        REQUIRE(a.calloc_top(cap / 4) != nullptr);
+        for (size_t i = 0; i < cap / 2; ++i)
+            REQUIRE(persistent[i] == 0x5a);
+    }
+
+    SECTION("reset() frees both ends")
+    {
+        REQUIRE(a.alloc(100) != nullptr);
+        REQUIRE(a.alloc_top(100) != nullptr);
+        REQUIRE(a.reset() == 0);
+        REQUIRE(a.get_used() == 0);
+        REQUIRE(a.get_used_top() == 0);
+        REQUIRE(a.alloc(cap) != nullptr);
+    }
+}
+
+TEST_CASE("Arena: In-place extension", "[arena][extend]")
+{
+    AL::arena a(PAGE_SIZE * 4);
+
+    SECTION("The most recent allocation grows without moving")
+    {
+        auto* p = static_cast<unsigned char*>(a.alloc(64));
+        std::memset(p, 0x3c, 64);
+        REQUIRE(a.try_extend(p, 64, 1024));
+        REQUIRE(a.get_used() == 1024);
+        std::memset(p + 64, 0x3d, 1024 - 64);
+
+        REQUIRE(a.realloc(p, 1024, 2048) == p);
+        REQUIRE(a.get_used() == 2048);
+        REQUIRE(p[0] == 0x3c);
+        REQUIRE(p[1023] == 0x3d);
+        if constexpr (AL::stats_enabled)
+            REQUIRE(a.stats().in_place_extends == 2);
+    }
+
+    SECTION("An older allocation cannot grow, realloc copies it")
+    {
+        auto* p = static_cast<unsigned char*>(a.alloc(64));
+        std::memset(p, 0x7e, 64);
+        REQUIRE(a.alloc(16) != nullptr);
+        REQUIRE_FALSE(a.try_extend(p, 64, 128));
+
+        auto* moved = static_cast<unsigned char*>(a.realloc(p, 64, 128));
+        REQUIRE(moved != nullptr);
+        REQUIRE(moved != p);
+        for (size_t i = 0; i < 64; ++i)
+            REQUIRE(moved[i] == 0x7e);
+    }
+
+    SECTION("Shrinking hands the tail back")
+    {
+        void* p = a.alloc(1000);
+        REQUIRE(a.try_extend(p, 1000, 100));
+        REQUIRE(a.get_used() == 100);
+        REQUIRE(a.realloc(p, 100, 50) == p);
+        REQUIRE(a.get_used() == 50);
+    }
+
+    SECTION("Growth stops at the capacity and at the top end")
+    {
+        void* p = a.alloc(64);
+        REQUIRE_FALSE(a.try_extend(p, 64, a.get_capacity() + 1));
+        REQUIRE(a.alloc_top(PAGE_SIZE) != nullptr);
+        REQUIRE_FALSE(a.try_extend(p, 64, a.get_capacity() - PAGE_SIZE + 1));
+        REQUIRE(a.try_extend(p, 64, a.get_capacity() - PAGE_SIZE));
+        REQUIRE(a.get_used() + a.get_used_top() == a.get_capacity());
+    }
+
+    SECTION("Foreign and null pointers")
+    {
+        int local = 0;
+        REQUIRE_FALSE(a.try_extend(&local, sizeof(local), 64));
+        void* p = a.realloc(nullptr, 0, 32);
+        REQUIRE(p != nullptr);
+        REQUIRE(a.realloc(p, 32, 0) == nullptr);
+    }
+
+    SECTION("Thread chunks grow inside the calling thread's chunk")
+    {
+        a.set_thread_chunk_size(1024);
+        void* p = a.alloc(64);
+        REQUIRE(a.try_extend(p, 64, 512));
+        REQUIRE(a.alloc(16) == static_cast<std::byte*>(p) + 512);
+        REQUIRE_FALSE(a.try_extend(p, 512, 600));
+        REQUIRE(a.get_used() == 1024);
+    }
+}
+
+TEST_CASE("Arena: Self-sizing capacity", "[arena][auto_size]")
+{
+    AL::arena a(PAGE_SIZE * 4);
+
+    // one cycle that wants `bytes`, allocated a page at a time
+    auto cycle = [&a](size_t bytes) {
+        size_t failed = 0;
+        for (size_t done = 0; done < bytes; done += PAGE_SIZE)
+        {
+            if (a.alloc(PAGE_SIZE, 1) == nullptr)
+                ++failed;
+        }
+        REQUIRE(a.reset() == 0);
+        return failed;
+    };
+
+    SECTION("Off by default")
+    {
+        cycle(PAGE_SIZE * 16);
+        REQUIRE(a.get_capacity() == PAGE_SIZE * 4);
+    }
+
+    SECTION("Grows to what failed requests needed")
+    {
+        a.set_auto_size(90, 10);
+        // four pages fit, the twelve that failed are added on
+        REQUIRE(cycle(PAGE_SIZE * 16) == 12);
+        REQUIRE(a.get_capacity() == PAGE_SIZE * 16);
+        REQUIRE(cycle(PAGE_SIZE * 16) == 0);
+
+        // the grown arena is still one contiguous block
+        auto* p = static_cast<unsigned char*>(a.alloc(PAGE_SIZE * 16, 1));
+        REQUIRE(p != nullptr);
+        std::memset(p, 0x42, PAGE_SIZE * 16);
+        if constexpr (AL::stats_enabled)
+            REQUIRE(a.stats().resizes == 1);
+    }
+
+    SECTION("Shrinks to the percentile and ignores a rare outlier")
+    {
+        a.set_auto_size(90, 10);
+        for (size_t i = 0; i < 20; ++i)
+            cycle(PAGE_SIZE * 16);
+        REQUIRE(a.get_capacity() == PAGE_SIZE * 16);
+
+        for (size_t i = 0; i < 10; ++i)
+            cycle(PAGE_SIZE * 2);
+        REQUIRE(a.get_capacity() == PAGE_SIZE * 2);
+        REQUIRE(a.get_resident() <= PAGE_SIZE * 2);
+
+        // one large cycle in ten is the 100th percentile, not the 90th
+        cycle(PAGE_SIZE * 8);
+        REQUIRE(a.get_capacity() == PAGE_SIZE * 2);
+
+        // growing back within the old mapping needs no remap
+        a.set_auto_size(100, 1);
+        REQUIRE(cycle(PAGE_SIZE * 12) == 10);
+        REQUIRE(a.get_capacity() == PAGE_SIZE * 12);
+        REQUIRE(a.alloc_top(PAGE_SIZE * 12, 1) != nullptr);
+    }
+
+    SECTION("Shrinking purges the pages the top end touched")
+    {
+        AL::arena big(PAGE_SIZE * 256);
+        big.set_auto_size(10, 2);
+        void* p = big.alloc_top(PAGE_SIZE * 192);
+        REQUIRE(p != nullptr);
+        std::memset(p, 1, PAGE_SIZE * 192);
+        REQUIRE(big.reset() == 0);
+        REQUIRE(big.get_capacity() == PAGE_SIZE * 192);
+
+        // an empty cycle is the lowest of the window, so the arena shrinks to a page
+        REQUIRE(big.reset() == 0);
+        REQUIRE(big.get_capacity() == PAGE_SIZE);
+        REQUIRE(big.get_resident() <= PAGE_SIZE);
+    }
+
+    SECTION("Survives a move")
+    {
+        a.set_auto_size(100, 1);
+        cycle(PAGE_SIZE * 8);
+        AL::arena b(std::move(a));
+        REQUIRE(b.get_capacity() == PAGE_SIZE * 8);
+        REQUIRE(b.alloc(PAGE_SIZE * 8, 1) != nullptr);
+        REQUIRE(b.reset() == 0);
+        REQUIRE(b.get_capacity() == PAGE_SIZE * 8);
+    }
+}
@@ -0,0 +1,225 @@
+#include "chained_arena.h"
+#include <atomic>
+#include <catch2/catch_test_macros.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using namespace AL;
+
+static const size_t PAGE = getpagesize();
+
+TEST_CASE("Chained arena: basic allocation", "[chained_arena]")
+{
+    chained_arena a(PAGE);
+    REQUIRE(a.get_block_count() == 1);
+    REQUIRE(a.get_used() == 0);
+    REQUIRE(a.get_capacity() > 0);
+    REQUIRE(a.get_capacity() < PAGE);
+
+    SECTION("Allocations are aligned and distinct")
+    {
+        constexpr size_t alignment = alignof(std::max_align_t);
+        void* p1 = a.alloc(10);
+        void* p2 = a.alloc(10);
+        REQUIRE(p1 != nullptr);
+        REQUIRE(p2 != nullptr);
+        REQUIRE(p1 != p2);
+        REQUIRE(reinterpret_cast<uintptr_t>(p1) % alignment == 0);
+        REQUIRE(reinterpret_cast<uintptr_t>(p2) % alignment == 0);
+    }
+
+    SECTION("Zero-size allocation returns nullptr")
+    {
+        REQUIRE(a.alloc(0) == nullptr);
+    }
+
+    SECTION("Calloc zeroes memory")
+    {
+        auto* p = static_cast<unsigned char*>(a.calloc(256));
+        REQUIRE(p != nullptr);
+        for (size_t i = 0; i < 256; ++i)
+            REQUIRE(p[i] == 0);
+    }
+}
+
+TEST_CASE("Chained arena: growth", "[chained_arena]")
+{
+    SECTION("A full block links a larger one")
+    {
+        chained_arena a(PAGE, {.factor = 2, .max_block_bytes = 64 * PAGE});
+        const size_t first = a.get_capacity();
+
+        std::vector<unsigned char*> ptrs;
+        size_t total = 0;
+        while (total < 32 * PAGE)
+        {
+            auto* p = static_cast<unsigned char*>(a.alloc(256));
+            REQUIRE(p != nullptr);
+            std::memset(p, static_cast<int>(ptrs.size() & 0xff), 256);
+            ptrs.push_back(p);
+            total += 256;
+        }
+
+        // 1 + 2 + 4 + 8 + 16 + 32 pages cover 32 pages of data, a flat policy needs 32+ blocks
+        REQUIRE(a.get_block_count() <= 6);
+        REQUIRE(a.get_capacity() > first);
+        REQUIRE(a.get_used() >= total);
+
+        // nothing was overwritten when blocks were linked
+        for (size_t i = 0; i < ptrs.size(); ++i)
+            for (size_t j = 0; j < 256; ++j)
+                REQUIRE(ptrs[i][j] == static_cast<unsigned char>(i & 0xff));
+    }
+
+    SECTION("Blocks stop growing at max_block_bytes")
+    {
+        chained_arena a(PAGE, {.factor = 4, .max_block_bytes = 4 * PAGE});
+        for (size_t i = 0; i < 64; ++i)
+            REQUIRE(a.alloc(PAGE / 2) != nullptr);
+
+        // 1 page, then 4 page blocks holding 7 half pages each
+        REQUIRE(a.get_block_count() >= 1 + (64 - 1) / 7);
+        REQUIRE(a.get_capacity() <= a.get_block_count() * 4 * PAGE);
+    }
+
+    SECTION("Allocations larger than the schedule get a block that fits")
+    {
+        chained_arena a(PAGE);
+        void* p = a.alloc(100 * PAGE);
+        REQUIRE(p != nullptr);
+        std::memset(p, 0xab, 100 * PAGE);
+        REQUIRE(a.get_block_count() == 2);
+        REQUIRE(a.get_capacity() >= 100 * PAGE);
+    }
+
+    SECTION("Stats count grows")
+    {
+        chained_arena a(PAGE);
+        REQUIRE(a.alloc(PAGE) != nullptr);
+        REQUIRE(a.alloc(4 * PAGE) != nullptr);
+
+        chained_arena_stats st = a.stats();
+        REQUIRE(st.blocks == a.get_block_count());
+        REQUIRE(st.used == a.get_used());
+        REQUIRE(st.capacity == a.get_capacity());
+        if constexpr (stats_enabled)
+            REQUIRE(st.grows == a.get_block_count() - 1);
+    }
+}
+
+TEST_CASE("Chained arena: reset keeps the largest block", "[chained_arena][reset]")
+{
+    chained_arena a(PAGE);
+    for (size_t i = 0; i < 200; ++i)
+        REQUIRE(a.alloc(128) != nullptr);
+    REQUIRE(a.get_block_count() > 1);
+
+    REQUIRE(a.reset() == 0);
+    REQUIRE(a.get_block_count() == 1);
+    REQUIRE(a.get_used() == 0);
+    const size_t kept = a.get_capacity();
+    REQUIRE(kept > PAGE);
+
+    SECTION("The next cycle of the same size fits in the kept block")
+    {
+        for (size_t i = 0; i < kept / 128; ++i)
+            REQUIRE(a.alloc(128) != nullptr);
+        REQUIRE(a.get_block_count() == 1);
+        if constexpr (stats_enabled)
+            REQUIRE(a.stats().resets == 1);
+    }
+
+    SECTION("An oversized allocation is set aside and not kept")
+    {
+        auto* small = static_cast<unsigned char*>(a.alloc(128));
+        REQUIRE(small != nullptr);
+        const size_t blocks = a.get_block_count();
+
+        void* big = a.alloc(64 * kept);
+        REQUIRE(big != nullptr);
+        std::memset(big, 0xab, 64 * kept);
+        REQUIRE(a.get_block_count() == blocks + 1);
+        REQUIRE(a.get_capacity() >= 65 * kept);
+
+        // the kept block still serves what fits it, right after the earlier allocation
+        auto* next = static_cast<unsigned char*>(a.alloc(128));
+        REQUIRE(next == small + 128);
+
+        // the outlier is unmapped, the scheduled block stays
+        REQUIRE(a.reset() == 0);
+        REQUIRE(a.get_block_count() == 1);
+        REQUIRE(a.get_capacity() == kept);
+    }
+
+    SECTION("Clear unmaps everything and starts over")
+    {
+        REQUIRE(a.clear() == 0);
+        REQUIRE(a.get_block_count() == 0);
+        REQUIRE(a.get_capacity() == 0);
+
+        REQUIRE(a.alloc(64) != nullptr);
+        REQUIRE(a.get_block_count() == 1);
+        REQUIRE(a.get_capacity() < PAGE);
+    }
+}
+
+TEST_CASE("Chained arena: concurrent allocation across growth", "[chained_arena][thread]")
+{
+    chained_arena a(PAGE);
+
+    constexpr size_t threads = 8;
+    constexpr size_t per_thread = 2000;
+    std::vector<std::vector<uint64_t*>> ptrs(threads);
+    std::vector<std::thread> workers;
+    std::atomic<size_t> failed{0};
+
+    for (size_t t = 0; t < threads; ++t)
+    {
+        workers.emplace_back([&, t] {
+            for (size_t i = 0; i < per_thread; ++i)
+            {
+                auto* p = static_cast<uint64_t*>(a.alloc(sizeof(uint64_t) * 4));
+                if (!p)
+                {
+                    failed.fetch_add(1);
+                    continue;
+                }
+                for (size_t j = 0; j < 4; ++j)
+                    p[j] = (t << 32) | i;
+                ptrs[t].push_back(p);
+            }
+        });
+    }
+    for (auto& w : workers)
+        w.join();
+
+    REQUIRE(failed.load() == 0);
+    REQUIRE(a.get_block_count() > 1);
+
+    // every allocation kept its own contents, so no two threads got overlapping memory
+    for (size_t t = 0; t < threads; ++t)
+        for (size_t i = 0; i < ptrs[t].size(); ++i)
+            for (size_t j = 0; j < 4; ++j)
+                REQUIRE(ptrs[t][i][j] == ((t << 32) | i));
+}
+
+TEST_CASE("Chained arena: caller-specified alignment", "[chained_arena][alignment]")
+{
+    chained_arena a(PAGE);
+
+    void* p1 = a.alloc(3, 1);
+    void* p2 = a.alloc(1, 1);
+    REQUIRE(static_cast<std::byte*>(p2) == static_cast<std::byte*>(p1) + 3);
+
+    // the new block has to leave room for the padding
+    void* page = a.alloc(PAGE, PAGE);
+    REQUIRE(page != nullptr);
+    REQUIRE(reinterpret_cast<uintptr_t>(page) % PAGE == 0);
+    std::memset(page, 0xcd, PAGE);
+
+    REQUIRE(a.alloc(8, 3) == nullptr);
+}
@@ -1,5 +1,12 @@
 #include "dynamic_slab.h"
+#include "page_map.h"
+#include <atomic>
+#include <chrono>
 #include <catch2/catch_test_macros.hpp>
+#include <cstring>
+#include <memory>
+#include <optional>
+#include <thread>
 #include <vector>
 
 using namespace AL;
@@ -163,3 +170,700 @@ TEST_CASE("Dynamic slab: invalid sizes", "[dynamic_slab]")
         ds.free(reinterpret_cast<void*>(0x1000), 0);
     }
 }
+
+TEST_CASE("Dynamic slab: stats snapshot", "[dynamic_slab][stats]")
+{
+    dynamic_slab ds(0.01);
+
+    std::vector<void*> ptrs;
+    for (size_t i = 0; i < 200; ++i)
+    {
+        void* p = ds.palloc(16);
+        REQUIRE(p != nullptr);
+        ptrs.push_back(p);
+    }
+
+    dynamic_slab_stats st = ds.stats();
+    REQUIRE(st.node_count == ds.get_slab_count());
+    REQUIRE(st.slabs.capacity == ds.get_total_capacity());
+    REQUIRE(st.slabs.free_bytes == ds.get_total_free());
+    if constexpr (stats_enabled)
+    {
+        REQUIRE(st.grows == st.node_count - 1);
+        REQUIRE(st.slabs.classes[1].pool.allocs >= 200);
+    }
+
+    for (void* p : ptrs)
+        ds.free(p, 16);
+}
+
+TEST_CASE("Dynamic slab: free resolves the owner across many slabs", "[dynamic_slab]")
+{
+    dynamic_slab ds(1.0);
+
+    // 256 blocks of 64B per slab, so this spans several slab nodes
+    std::vector<void*> ptrs;
+    for (size_t i = 0; i < 2000; ++i)
+    {
+        void* p = ds.palloc(64);
+        REQUIRE(p != nullptr);
+        ptrs.push_back(p);
+    }
+    REQUIRE(ds.get_slab_count() > 4);
+
+    // free oldest first so most frees land in a node far from head
+    for (void* p : ptrs)
+        ds.free(p, 64);
+
+    // every block made it back to a pool or a thread cache, so they can all be handed out again
+    // without growing any further
+    const size_t nodes = ds.get_slab_count();
+    for (size_t i = 0; i < ptrs.size(); ++i)
+        REQUIRE(ds.palloc(64) != nullptr);
+    REQUIRE(ds.get_slab_count() == nodes);
+
+    SECTION("Foreign pointers are ignored")
+    {
+        int local = 0;
+        ds.free(&local, 64);
+        REQUIRE(ds.get_slab_count() == nodes);
+    }
+}
+
+TEST_CASE("Dynamic slab: trim releases empty slabs", "[dynamic_slab]")
+{
+    dynamic_slab ds(1.0);
+
+    std::vector<void*> ptrs;
+    for (size_t i = 0; i < 4000; ++i)
+    {
+        void* p = ds.palloc(64);
+        REQUIRE(p != nullptr);
+        ptrs.push_back(p);
+    }
+    const size_t grown = ds.get_slab_count();
+    const size_t grown_capacity = ds.get_total_capacity();
+    REQUIRE(grown > 4);
+
+    SECTION("Slabs with live blocks are kept")
+    {
+        ds.trim();
+        REQUIRE(ds.get_slab_count() == grown);
+
+        for (void* p : ptrs)
+            ds.free(p, 64);
+    }
+
+    SECTION("Empty slabs are released down to the retained count")
+    {
+        for (void* p : ptrs)
+            ds.free(p, 64);
+
+        REQUIRE(ds.trim() == grown - 1);
+        REQUIRE(ds.get_slab_count() == 1);
+        REQUIRE(ds.get_total_capacity() < grown_capacity);
+
+        if constexpr (AL::stats_enabled)
+            REQUIRE(ds.stats().releases == grown - 1);
+
+        // grows again on demand
+        for (size_t i = 0; i < ptrs.size(); ++i)
+        {
+            ptrs[i] = ds.palloc(64);
+            REQUIRE(ptrs[i] != nullptr);
+        }
+        REQUIRE(ds.get_slab_count() == grown);
+        for (void* p : ptrs)
+            ds.free(p, 64);
+    }
+
+    SECTION("Retained empty slabs stay mapped")
+    {
+        ds.set_retained_empty_nodes(3);
+        for (void* p : ptrs)
+            ds.free(p, 64);
+
+        ds.trim();
+        REQUIRE(ds.get_slab_count() == 3);
+    }
+
+    SECTION("Frees trim automatically once the release delay has passed")
+    {
+        ds.set_retained_empty_nodes(0);
+        ds.set_release_delay(std::chrono::milliseconds(0));
+        for (void* p : ptrs)
+            ds.free(p, 64);
+
+        // churn a different size class to drive the automatic passes
+        for (size_t i = 0; i < 3 * 4096; ++i)
+            ds.free(ds.palloc(8), 8);
+
+        // only slabs still referenced by this thread's caches can survive
+        REQUIRE(ds.get_slab_count() < grown);
+    }
+
+    SECTION("Automatic passes keep recently emptied slabs")
+    {
+        ds.set_retained_empty_nodes(0);
+        for (void* p : ptrs)
+            ds.free(p, 64);
+
+        for (size_t i = 0; i < 3 * 4096; ++i)
+            ds.free(ds.palloc(8), 8);
+
+        // the default delay is far longer than this loop
+        REQUIRE(ds.get_slab_count() == grown);
+    }
+}
+
+TEST_CASE("Dynamic slab: trim is safe under concurrent alloc/free", "[dynamic_slab][thread]")
+{
+    dynamic_slab ds(1.0);
+    ds.set_retained_empty_nodes(0);
+
+    constexpr size_t workers = 4;
+    constexpr size_t rounds = 200;
+    constexpr size_t hold = 600;
+    std::atomic<bool> done{false};
+    std::atomic<size_t> corrupted{0};
+
+    std::thread trimmer([&] {
+        while (!done.load(std::memory_order_acquire))
+        {
+            ds.trim();
+            std::this_thread::yield();
+        }
+    });
+
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < workers; ++t)
+    {
+        threads.emplace_back([&, t] {
+            std::vector<unsigned char*> ptrs(hold);
+            for (size_t r = 0; r < rounds; ++r)
+            {
+                const unsigned char tag = static_cast<unsigned char>(t * 31 + r);
+                for (auto& p : ptrs)
+                {
+                    p = static_cast<unsigned char*>(ds.palloc(32));
+                    if (p)
+                        std::memset(p, tag, 32);
+                }
+                for (auto* p : ptrs)
+                {
+                    if (!p)
+                        continue;
+                    for (size_t i = 0; i < 32; ++i)
+                        if (p[i] != tag)
+                        {
+                            corrupted.fetch_add(1, std::memory_order_relaxed);
+                            break;
+                        }
+                    ds.free(p, 32);
+                }
+            }
+        });
+    }
+
+    for (auto& th : threads)
+        th.join();
+    done.store(true, std::memory_order_release);
+    trimmer.join();
+
+    REQUIRE(corrupted.load() == 0);
+    REQUIRE(ds.get_slab_count() >= 1);
+}
+
+TEST_CASE("Dynamic slab: palloc reuses room in older slabs before growing", "[dynamic_slab]")
+{
+    dynamic_slab ds(1.0);
+
+    std::vector<void*> ptrs;
+    for (size_t i = 0; i < 3000; ++i)
+    {
+        void* p = ds.palloc(128);
+        REQUIRE(p != nullptr);
+        ptrs.push_back(p);
+    }
+    const size_t grown = ds.get_slab_count();
+    REQUIRE(grown > 4);
+
+    SECTION("Freed blocks in the oldest slab are found again")
+    {
+        // the first 128 blocks came from the oldest slab
+        for (size_t i = 0; i < 100; ++i)
+            ds.free(ptrs[i], 128);
+        for (size_t i = 0; i < 100; ++i)
+        {
+            ptrs[i] = ds.palloc(128);
+            REQUIRE(ptrs[i] != nullptr);
+        }
+        REQUIRE(ds.get_slab_count() == grown);
+    }
+
+    SECTION("Other size classes do not skip over full slabs one by one")
+    {
+        // every slab still has room for 8B blocks, so none of these should grow the list
+        std::vector<void*> small;
+        for (size_t i = 0; i < 500; ++i)
+        {
+            void* p = ds.palloc(8);
+            REQUIRE(p != nullptr);
+            small.push_back(p);
+        }
+        REQUIRE(ds.get_slab_count() == grown);
+        for (void* p : small)
+            ds.free(p, 8);
+    }
+
+    for (void* p : ptrs)
+        ds.free(p, 128);
+}
+
+TEST_CASE("Dynamic slab: hold and release across threads keeps slab count bounded", "[dynamic_slab][thread]")
+{
+    dynamic_slab ds(1.0);
+
+    constexpr size_t workers = 4;
+    constexpr size_t rounds = 100;
+    constexpr size_t hold = 500;
+    std::atomic<size_t> failed{0};
+
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < workers; ++t)
+    {
+        threads.emplace_back([&] {
+            std::vector<void*> ptrs(hold);
+            for (size_t r = 0; r < rounds; ++r)
+            {
+                for (auto& p : ptrs)
+                {
+                    p = ds.palloc(32);
+                    if (p == nullptr)
+                        failed.fetch_add(1, std::memory_order_relaxed);
+                }
+                for (void* p : ptrs)
+                    ds.free(p, 32);
+            }
+        });
+    }
+    for (auto& th : threads)
+        th.join();
+
+    REQUIRE(failed.load() == 0);
+
+    // 256 blocks of 32B per slab. reuse has to keep the list close to what the peak needs,
+    // with slack for blocks parked in thread caches
+    REQUIRE(ds.get_slab_count() <= (workers * hold) / 256 + 2 * workers + 2);
+}
+
+TEST_CASE("Dynamic slab: geometric growth", "[dynamic_slab]")
+{
+    // 128B blocks per node at scale 1
+    constexpr size_t per_scale = 128;
+
+    SECTION("Node scale multiplies until max_scale")
+    {
+        dynamic_slab ds(1, {.factor = 2, .max_scale = 8});
+        const size_t unit = ds.get_total_capacity();
+
+        std::vector<void*> ptrs;
+        for (size_t i = 0; i < 3000; ++i)
+        {
+            void* p = ds.palloc(128);
+            REQUIRE(p != nullptr);
+            ptrs.push_back(p);
+        }
+
+        // scales 1, 2, 4, 8, 8, 8 hold 31 * 128 blocks, a flat policy needs 24 nodes
+        REQUIRE(ds.get_slab_count() <= 6);
+        REQUIRE(ds.get_total_capacity() <= 31 * unit);
+        REQUIRE(ds.get_total_capacity() >= 3000 / per_scale * unit / 2);
+
+        for (void* p : ptrs)
+            ds.free(p, 128);
+    }
+
+    SECTION("A fractional first scale still grows")
+    {
+        // 0.01 truncates to a scale of 0, one block per size class
+        dynamic_slab ds(0.01, {.factor = 2, .max_scale = 8});
+
+        std::vector<void*> ptrs;
+        for (size_t i = 0; i < 3000; ++i)
+        {
+            void* p = ds.palloc(128);
+            REQUIRE(p != nullptr);
+            ptrs.push_back(p);
+        }
+
+        // scales 0, 2, 4, 8, 8, 8 hold 1 + 30 * 128 blocks, without growth it takes 3000 nodes
+        REQUIRE(ds.get_slab_count() <= 6);
+
+        for (void* p : ptrs)
+            ds.free(p, 128);
+    }
+
+    SECTION("Default policy keeps every node the same size")
+    {
+        dynamic_slab ds(1);
+        const size_t unit = ds.get_total_capacity();
+
+        std::vector<void*> ptrs;
+        for (size_t i = 0; i < 4 * per_scale; ++i)
+            ptrs.push_back(ds.palloc(128));
+
+        REQUIRE(ds.get_total_capacity() == ds.get_slab_count() * unit);
+        for (void* p : ptrs)
+            ds.free(p, 128);
+    }
+
+    SECTION("Reserved nodes are mapped up front and survive trim")
+    {
+        dynamic_slab ds(1, {.reserve_nodes = 3});
+        REQUIRE(ds.get_slab_count() == 3);
+
+        // the reserve covers this without growing
+        std::vector<void*> ptrs;
+        for (size_t i = 0; i < 3 * per_scale - 64; ++i)
+        {
+            void* p = ds.palloc(128);
+            REQUIRE(p != nullptr);
+            ptrs.push_back(p);
+        }
+        REQUIRE(ds.get_slab_count() == 3);
+
+        for (void* p : ptrs)
+            ds.free(p, 128);
+        ds.trim();
+        REQUIRE(ds.get_slab_count() == 3);
+    }
+}
+
+TEST_CASE("Dynamic slab: home nodes", "[dynamic_slab][thread]")
+{
+    SECTION("Each thread slot gets its own node")
+    {
+        dynamic_slab ds(1.0);
+        ds.set_home_nodes(4);
+
+        std::vector<std::thread> threads;
+        std::atomic<size_t> failed{0};
+        for (size_t t = 0; t < 4; ++t)
+        {
+            threads.emplace_back([&] {
+                void* p = ds.palloc(64);
+                if (p == nullptr)
+                    failed.fetch_add(1, std::memory_order_relaxed);
+                ds.free(p, 64);
+            });
+        }
+        for (auto& th : threads)
+            th.join();
+
+        // consecutive threads land in distinct slots, the first one takes the initial node
+        REQUIRE(failed.load() == 0);
+        REQUIRE(ds.get_slab_count() == 4);
+    }
+
+    SECTION("An exhausted home spills to other nodes")
+    {
+        dynamic_slab ds(1.0);
+        ds.set_home_nodes(1);
+
+        std::vector<void*> ptrs;
+        for (size_t i = 0; i < 1000; ++i)
+        {
+            void* p = ds.palloc(128);
+            REQUIRE(p != nullptr);
+            ptrs.push_back(p);
+        }
+        REQUIRE(ds.get_slab_count() > 1);
+        for (void* p : ptrs)
+            ds.free(p, 128);
+    }
+
+    SECTION("A slot that failed to get a home shares the list without retrying")
+    {
+        dynamic_slab ds(1.0);
+        ds.set_memory_limits(0, ds.get_mapped_bytes());
+        ds.set_home_nodes(2);
+
+        // the first thread takes the only node as its home
+        std::thread([&] {
+            void* p = ds.palloc(128);
+            REQUIRE(p != nullptr);
+            ds.free(p, 128);
+        }).join();
+
+        // the next thread's slot cannot grow a home, so every refill falls back to the shared node
+        std::thread([&] {
+            std::vector<void*> ptrs;
+            for (size_t i = 0; i < 64; ++i)
+            {
+                void* p = ds.palloc(128);
+                REQUIRE(p != nullptr);
+                ptrs.push_back(p);
+            }
+            for (void* p : ptrs)
+                ds.free(p, 128);
+        }).join();
+
+        REQUIRE(ds.get_slab_count() == 1);
+        // one failed assignment, not one per refill
+        if constexpr (stats_enabled)
+            REQUIRE(ds.stats().grow_failures == 1);
+    }
+
+    SECTION("A home node released by trim is replaced")
+    {
+        dynamic_slab ds(1, {.reserve_nodes = 3});
+        ds.set_home_nodes(1);
+
+        void* p = ds.palloc(64);
+        REQUIRE(p != nullptr);
+        ds.free(p, 64);
+
+        ds.set_retained_empty_nodes(0);
+        REQUIRE(ds.trim() == 2);
+
+        // the surviving node becomes home, nothing new is mapped
+        p = ds.palloc(64);
+        REQUIRE(p != nullptr);
+        REQUIRE(ds.get_slab_count() == 1);
+        ds.free(p, 64);
+    }
+}
+
+TEST_CASE("Dynamic slab: thread cache spans every node", "[dynamic_slab][tlc]")
+{
+    SECTION("Blocks from many nodes are cached and returned to their owners")
+    {
+        dynamic_slab ds(1.0);
+        std::vector<void*> ptrs;
+        for (size_t i = 0; i < 2000; ++i)
+            ptrs.push_back(ds.palloc(64));
+        REQUIRE(ds.get_slab_count() > 4);
+
+        // frees land in one cache regardless of which node they came from
+        for (void* p : ptrs)
+            ds.free(p, 64);
+        REQUIRE(ds.get_total_free() < ds.get_total_capacity());
+
+        ds.trim();
+        REQUIRE(ds.get_total_free() == ds.get_total_capacity());
+
+        // churn stays in the cache however many nodes there are
+        const dynamic_slab_stats before = ds.stats();
+        for (size_t i = 0; i < 1000; ++i)
+            ds.free(ds.palloc(64), 64);
+        const dynamic_slab_stats after = ds.stats();
+        if constexpr (stats_enabled)
+        {
+            REQUIRE(after.slabs.classes[3].tlc_hits - before.slabs.classes[3].tlc_hits >= 999);
+            REQUIRE(after.slabs.thread_caches == 1);
+        }
+    }
+
+    SECTION("More dynamic_slabs than cache slots")
+    {
+        std::vector<std::unique_ptr<dynamic_slab>> instances;
+        for (size_t i = 0; i < 6; ++i)
+            instances.push_back(std::make_unique<dynamic_slab>(1.0));
+
+        for (size_t round = 0; round < 50; ++round)
+        {
+            for (auto& ds : instances)
+            {
+                void* p = ds->palloc(32);
+                REQUIRE(p != nullptr);
+                REQUIRE(ds->stats().node_count >= 1);
+                ds->free(p, 32);
+            }
+        }
+
+        for (auto& ds : instances)
+        {
+            ds->trim();
+            REQUIRE(ds->get_total_free() == ds->get_total_capacity());
+        }
+    }
+
+    SECTION("Exiting threads return their cached blocks")
+    {
+        dynamic_slab ds(1.0);
+        std::vector<std::thread> threads;
+        for (size_t t = 0; t < 4; ++t)
+        {
+            threads.emplace_back([&] {
+                std::vector<void*> ptrs;
+                for (size_t i = 0; i < 300; ++i)
+                    ptrs.push_back(ds.palloc(128));
+                for (void* p : ptrs)
+                    ds.free(p, 128);
+            });
+        }
+        for (auto& th : threads)
+            th.join();
+
+        REQUIRE(ds.get_total_free() == ds.get_total_capacity());
+    }
+
+    SECTION("Destroying a dynamic_slab detaches other threads' caches")
+    {
+        std::optional<dynamic_slab> ds;
+        ds.emplace(1.0);
+
+        std::atomic<bool> cached{false};
+        std::atomic<bool> replaced{false};
+        std::atomic<bool> done{false};
+        std::atomic<bool> checked{false};
+        std::thread worker([&] {
+            void* p = ds->palloc(32);
+            ds->free(p, 32);
+            cached.store(true, std::memory_order_release);
+
+            while (!replaced.load(std::memory_order_acquire))
+                std::this_thread::yield();
+            p = ds->palloc(32);
+            ds->free(p, 32);
+            done.store(true, std::memory_order_release);
+
+            // exiting returns the cached blocks, so stay until the pool has been checked
+            while (!checked.load(std::memory_order_acquire))
+                std::this_thread::yield();
+        });
+
+        while (!cached.load(std::memory_order_acquire))
+            std::this_thread::yield();
+        // same address, so a stale entry would still match it
+        ds.reset();
+        ds.emplace(1.0);
+        replaced.store(true, std::memory_order_release);
+
+        while (!done.load(std::memory_order_acquire))
+            std::this_thread::yield();
+        // the worker had to refill from the new instance instead of handing out old blocks
+        REQUIRE(ds->get_total_free() < ds->get_total_capacity());
+        checked.store(true, std::memory_order_release);
+        worker.join();
+        REQUIRE(ds->get_total_free() == ds->get_total_capacity());
+    }
+}
+
+TEST_CASE("Dynamic slab: memory limits", "[dynamic_slab]")
+{
+    SECTION("Mapped bytes follow the nodes")
+    {
+        dynamic_slab ds(1.0);
+        ds.set_retained_empty_nodes(0);
+        const size_t one_node = ds.get_mapped_bytes();
+        REQUIRE(one_node > ds.get_total_capacity());
+
+        std::vector<void*> ptrs;
+        for (size_t i = 0; i < 3 * 128; ++i)
+            ptrs.push_back(ds.palloc(128));
+        REQUIRE(ds.get_slab_count() == 3);
+        REQUIRE(ds.get_mapped_bytes() == 3 * one_node);
+        REQUIRE(ds.stats().mapped_bytes == ds.get_mapped_bytes());
+
+        for (void* p : ptrs)
+            ds.free(p, 128);
+        ds.trim();
+        REQUIRE(ds.get_mapped_bytes() == ds.get_slab_count() * one_node);
+    }
+
+    SECTION("Hard limit fails allocations instead of growing")
+    {
+        dynamic_slab ds(1.0);
+        const size_t one_node = ds.get_mapped_bytes();
+        ds.set_memory_limits(0, 3 * one_node);
+
+        std::vector<void*> ptrs;
+        while (void* p = ds.palloc(128))
+        {
+            ptrs.push_back(p);
+            REQUIRE(ptrs.size() <= 3 * 128);
+        }
+        REQUIRE(ptrs.size() == 3 * 128);
+        REQUIRE(ds.get_slab_count() == 3);
+        REQUIRE(ds.get_mapped_bytes() <= 3 * one_node);
+        if constexpr (stats_enabled)
+        {
+            REQUIRE(ds.stats().hard_limit_failures >= 1);
+            REQUIRE(ds.stats().grow_failures >= ds.stats().hard_limit_failures);
+        }
+
+        // freed blocks can be handed out again, and lifting the limit allows growth
+        ds.free(ptrs.back(), 128);
+        ptrs.back() = ds.palloc(128);
+        REQUIRE(ptrs.back() != nullptr);
+        ds.set_memory_limits(0, 0);
+        ptrs.push_back(ds.palloc(128));
+        REQUIRE(ptrs.back() != nullptr);
+        REQUIRE(ds.get_slab_count() == 4);
+
+        for (void* p : ptrs)
+            ds.free(p, 128);
+    }
+
+#ifdef PALLOC_TESTING
+    SECTION("A failed page map insert leaves the mapped bytes unchanged")
+    {
+        dynamic_slab ds(1.0);
+        const size_t one_node = ds.get_mapped_bytes();
+        ds.set_memory_limits(0, 2 * one_node);
+
+        // the first node holds 32 blocks of 4096B, the 33rd needs a second node
+        std::vector<void*> ptrs;
+        for (size_t i = 0; i < 32; ++i)
+            ptrs.push_back(ds.palloc(4096));
+
+        // the second pool of the new node fails to register
+        page_map::fail_insert_countdown = 2;
+        REQUIRE(ds.palloc(4096) == nullptr);
+        page_map::fail_insert_countdown = 0;
+        REQUIRE(ds.get_mapped_bytes() == one_node);
+        REQUIRE(ds.get_slab_count() == 1);
+
+        // the limit check still sees the real total, so the slab can grow
+        ptrs.push_back(ds.palloc(4096));
+        REQUIRE(ptrs.back() != nullptr);
+        REQUIRE(ds.get_mapped_bytes() == 2 * one_node);
+
+        for (void* p : ptrs)
+            ds.free(p, 4096);
+    }
+#endif
+
+    SECTION("Soft limit flushes the thread cache before growing")
+    {
+        dynamic_slab ds(1.0);
+        ds.set_memory_limits(ds.get_mapped_bytes(), 0);
+
+        // fill the first node's 128B pool, then park every block in this thread's cache
+        std::vector<void*> small;
+        for (size_t i = 0; i < 128; ++i)
+            small.push_back(ds.palloc(128));
+        for (void* p : small)
+            ds.free(p, 128);
+
+        // the first node holds 32 blocks of 4096B, the 33rd needs a second node
+        std::vector<void*> large;
+        for (size_t i = 0; i < 33; ++i)
+        {
+            void* p = ds.palloc(4096);
+            REQUIRE(p != nullptr);
+            large.push_back(p);
+        }
+        REQUIRE(ds.get_slab_count() == 2);
+
+        // only the 4096B blocks and one refill batch are missing from the pools, the 128B ones came back
+        REQUIRE(ds.get_total_free() >= ds.get_total_capacity() - 36 * 4096);
+        if constexpr (stats_enabled)
+            REQUIRE(ds.stats().soft_limit_hits == 1);
+
+        for (void* p : large)
+            ds.free(p, 4096);
+    }
+}
@@ -0,0 +1,50 @@
+#include "epoch_domain.h"
+#include <atomic>
+#include <catch2/catch_test_macros.hpp>
+#include <thread>
+
+using namespace AL;
+
+TEST_CASE("Epoch domain: safe when no thread is pinned", "[epoch_domain]")
+{
+    const uint64_t e = epoch_domain::retire();
+    REQUIRE(epoch_domain::is_safe(e));
+}
+
+TEST_CASE("Epoch domain: a pinned reader holds back reclamation", "[epoch_domain][thread]")
+{
+    std::atomic<bool> pinned{false};
+    std::atomic<bool> release{false};
+
+    std::thread reader([&] {
+        epoch_domain::guard guard;
+        pinned.store(true, std::memory_order_release);
+        while (!release.load(std::memory_order_acquire))
+            std::this_thread::yield();
+    });
+
+    while (!pinned.load(std::memory_order_acquire))
+        std::this_thread::yield();
+
+    const uint64_t e = epoch_domain::retire();
+    REQUIRE_FALSE(epoch_domain::is_safe(e));
+
+    release.store(true, std::memory_order_release);
+    reader.join();
+    REQUIRE(epoch_domain::is_safe(e));
+}
+
+TEST_CASE("Epoch domain: readers pinned after retire do not block it", "[epoch_domain]")
+{
+    const uint64_t e = epoch_domain::retire();
+
+    epoch_domain::guard outer;
+    {
+        epoch_domain::guard nested;
+        REQUIRE(epoch_domain::is_safe(e));
+    }
+    REQUIRE(epoch_domain::is_safe(e));
+
+    // still pinned by outer, at an epoch older than the next retirement
+    REQUIRE_FALSE(epoch_domain::is_safe(epoch_domain::retire()));
+}
@@ -0,0 +1,108 @@
+#include "frame_arena.h"
+#include <catch2/catch_test_macros.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using namespace AL;
+
+static const size_t PAGE = getpagesize();
+
+TEST_CASE("Frame arena: data lives exactly N frames", "[frame_arena]")
+{
+    frame_arena<3> frames(PAGE);
+    REQUIRE(frames.get_frame() == 0);
+    REQUIRE(frames.get_capacity() == PAGE);
+
+    std::vector<unsigned char*> per_frame;
+    for (int f = 0; f < 3; ++f)
+    {
+        auto* p = static_cast<unsigned char*>(frames.alloc(PAGE));
+        REQUIRE(p != nullptr);
+        std::memset(p, f + 1, PAGE);
+        per_frame.push_back(p);
+        REQUIRE(frames.next_frame() == 0);
+    }
+
+    // frame 3 reuses frame 0's arena, frames 1 and 2 are untouched
+    REQUIRE(frames.get_frame() == 3);
+    auto* reused = static_cast<unsigned char*>(frames.alloc(PAGE));
+    REQUIRE(reused == per_frame[0]);
+    std::memset(reused, 0xff, PAGE);
+    for (size_t i = 0; i < PAGE; ++i)
+    {
+        REQUIRE(per_frame[1][i] == 2);
+        REQUIRE(per_frame[2][i] == 3);
+    }
+}
+
+TEST_CASE("Frame arena: each frame has its own capacity", "[frame_arena]")
+{
+    frame_arena<2> frames(PAGE);
+    REQUIRE(frames.alloc(PAGE) != nullptr);
+    REQUIRE(frames.alloc(1) == nullptr);
+
+    REQUIRE(frames.next_frame() == 0);
+    REQUIRE(frames.alloc(PAGE) != nullptr);
+
+    if constexpr (stats_enabled)
+        REQUIRE(frames.stats().failed_allocs == 1);
+}
+
+TEST_CASE("Frame arena: per-frame usage stats", "[frame_arena][stats]")
+{
+    frame_arena<2> frames(PAGE * 4);
+
+    REQUIRE(frames.alloc(100, 1) != nullptr);
+    REQUIRE(frames.next_frame() == 0);
+    REQUIRE(frames.alloc(3000, 1) != nullptr);
+    REQUIRE(frames.next_frame() == 0);
+    REQUIRE(frames.alloc(500, 1) != nullptr);
+
+    frame_arena_stats st = frames.stats();
+    REQUIRE(st.frame == 2);
+    REQUIRE(st.used == 500);
+    REQUIRE(st.last_frame_used == 3000);
+    REQUIRE(st.peak_frame_used == 3000);
+    REQUIRE(st.capacity == PAGE * 4);
+
+    REQUIRE(frames.next_frame() == 0);
+    REQUIRE(frames.stats().last_frame_used == 500);
+    REQUIRE(frames.stats().peak_frame_used == 3000);
+}
+
+TEST_CASE("Frame arena: objects are destroyed when their frame is recycled", "[frame_arena][make]")
+{
+    frame_arena<2> frames(PAGE);
+    std::string* s = frames.current().make<std::string>(64, 'x');
+    REQUIRE(s != nullptr);
+    REQUIRE(s->size() == 64);
+
+    // the string's heap buffer is freed by ~basic_string when frame 0's arena is reset at frame 2
+    REQUIRE(frames.next_frame() == 0);
+    REQUIRE(s->size() == 64);
+    REQUIRE(frames.next_frame() == 0);
+    REQUIRE(frames.current().get_used() == 0);
+}
+
+TEST_CASE("Frame arena: thread chunks", "[frame_arena][chunks]")
+{
+    frame_arena<2> frames(PAGE * 16);
+    frames.set_thread_chunk_size(1024);
+
+    REQUIRE(frames.alloc(16) != nullptr);
+    REQUIRE(frames.stats().used == 1024);
+
+    // the next frame is a different arena, every thread starts a new chunk there
+    REQUIRE(frames.next_frame() == 0);
+    void* other = nullptr;
+    std::thread t([&] { other = frames.alloc(16); });
+    t.join();
+    REQUIRE(other != nullptr);
+    REQUIRE(frames.alloc(16) != nullptr);
+    REQUIRE(frames.stats().used == 2048);
+}
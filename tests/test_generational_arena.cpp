@@ -0,0 +1,155 @@
+#include "generational_arena.h"
+#include <atomic>
+#include <catch2/catch_test_macros.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using namespace AL;
+
+static const size_t PAGE = getpagesize();
+
+TEST_CASE("Generational arena: basic allocation", "[generational_arena]")
+{
+    generational_arena a(PAGE);
+    REQUIRE(a.get_capacity() == PAGE);
+    REQUIRE(a.get_used() == 0);
+    REQUIRE(a.get_generation() == 0);
+
+    SECTION("Allocations are aligned and bump the offset")
+    {
+        void* p1 = a.alloc(10);
+        void* p2 = a.alloc(10);
+        REQUIRE(p1 != nullptr);
+        REQUIRE(p2 != nullptr);
+        REQUIRE(reinterpret_cast<uintptr_t>(p2) % alignof(std::max_align_t) == 0);
+        REQUIRE(a.get_used() == alignof(std::max_align_t) + 10);
+
+        void* p3 = a.alloc(3, 1);
+        void* p4 = a.alloc(1, 1);
+        REQUIRE(static_cast<std::byte*>(p4) == static_cast<std::byte*>(p3) + 3);
+        REQUIRE(a.alloc(8, 12) == nullptr);
+        REQUIRE(a.alloc(0) == nullptr);
+    }
+
+    SECTION("A generation holds at most its capacity")
+    {
+        REQUIRE(a.alloc(PAGE) != nullptr);
+        REQUIRE(a.alloc(1, 1) == nullptr);
+        if constexpr (stats_enabled)
+            REQUIRE(a.stats().failed_allocs == 1);
+    }
+
+    SECTION("Calloc zeroes memory")
+    {
+        auto* p = static_cast<unsigned char*>(a.calloc(256));
+        REQUIRE(p != nullptr);
+        for (size_t i = 0; i < 256; ++i)
+            REQUIRE(p[i] == 0);
+    }
+}
+
+TEST_CASE("Generational arena: capacity fits the packed offset", "[generational_arena]")
+{
+    // the offset shares the atomic word with the generation, in its low 40 bits
+    constexpr uint64_t offset_limit = uint64_t(1) << 40;
+
+    // both round up to a capacity of exactly 2^40, which the offset cannot hold
+    REQUIRE_THROWS_AS(generational_arena(offset_limit - 1), std::bad_alloc);
+    REQUIRE_THROWS_AS(generational_arena(offset_limit - PAGE + 1), std::bad_alloc);
+    REQUIRE_THROWS_AS(generational_arena(offset_limit), std::bad_alloc);
+}
+
+TEST_CASE("Generational arena: reset alternates halves", "[generational_arena][reset]")
+{
+    generational_arena a(PAGE);
+
+    auto* first = static_cast<unsigned char*>(a.alloc(PAGE));
+    REQUIRE(first != nullptr);
+    std::memset(first, 0x11, PAGE);
+
+    REQUIRE(a.reset() == 0);
+    REQUIRE(a.get_generation() == 1);
+    REQUIRE(a.get_used() == 0);
+
+    // the new generation has its full capacity and leaves the previous one alone
+    auto* second = static_cast<unsigned char*>(a.alloc(PAGE));
+    REQUIRE(second != nullptr);
+    REQUIRE(second != first);
+    std::memset(second, 0x22, PAGE);
+    for (size_t i = 0; i < PAGE; ++i)
+        REQUIRE(first[i] == 0x11);
+
+    // two resets later the first half is reused
+    REQUIRE(a.reset() == 0);
+    REQUIRE(a.alloc(1) == first);
+
+    generational_arena_stats st = a.stats();
+    REQUIRE(st.generation == 2);
+    REQUIRE(st.capacity == PAGE);
+    if constexpr (stats_enabled)
+        REQUIRE(st.resets == 2);
+}
+
+TEST_CASE("Generational arena: reset concurrent with allocation", "[generational_arena][thread]")
+{
+    const size_t capacity = PAGE * 64;
+    generational_arena a(capacity);
+
+    constexpr size_t threads = 4;
+    constexpr size_t per_thread = 20000;
+    std::atomic<bool> done{false};
+    std::atomic<size_t> out_of_range{0};
+    std::vector<size_t> failed(threads, 0);
+    std::vector<std::thread> workers;
+
+    const auto* low = static_cast<std::byte*>(a.alloc(1, 1));
+    REQUIRE(a.reset() == 0);
+    const auto* other = static_cast<std::byte*>(a.alloc(1, 1));
+    const std::byte* begin = std::min(low, other);
+
+    for (size_t t = 0; t < threads; ++t)
+    {
+        workers.emplace_back([&, t] {
+            for (size_t i = 0; i < per_thread; ++i)
+            {
+                auto* p = static_cast<std::byte*>(a.alloc(32));
+                if (p == nullptr)
+                {
+                    ++failed[t];
+                    continue;
+                }
+                if (p < begin || p + 32 > begin + capacity * 2)
+                    out_of_range.fetch_add(1, std::memory_order_relaxed);
+                std::memset(p, static_cast<int>(t), 32);
+            }
+        });
+    }
+
+    // resets often enough that no generation fills up
+    std::thread resetter([&] {
+        while (!done.load(std::memory_order_acquire))
+        {
+            if (a.get_used() > capacity / 2)
+                a.reset();
+            std::this_thread::yield();
+        }
+    });
+
+    for (auto& w : workers)
+        w.join();
+    done.store(true, std::memory_order_release);
+    resetter.join();
+
+    REQUIRE(out_of_range.load() == 0);
+    size_t total_failed = 0;
+    for (size_t f : failed)
+        total_failed += f;
+    // a generation can still fill up if the resetter is not scheduled in time, but not every allocation fails
+    REQUIRE(total_failed < threads * per_thread);
+    REQUIRE(a.get_used() <= capacity);
+}
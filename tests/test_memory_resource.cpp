@@ -0,0 +1,141 @@
+#include "memory_resource.h"
+#include <catch2/catch_test_macros.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory_resource>
+#include <new>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+using namespace AL;
+
+static const size_t PAGE = getpagesize();
+
+namespace
+{
+// fills a few std::pmr containers from r and checks their contents
+void exercise(std::pmr::memory_resource& r)
+{
+    std::pmr::vector<uint64_t> v(&r);
+    for (uint64_t i = 0; i < 200; ++i)
+        v.push_back(i * 3);
+    for (uint64_t i = 0; i < 200; ++i)
+        REQUIRE(v[i] == i * 3);
+
+    std::pmr::list<int> l(&r);
+    for (int i = 0; i < 100; ++i)
+        l.push_back(i);
+    l.remove_if([](int i) { return i % 2 == 0; });
+    REQUIRE(l.size() == 50);
+    REQUIRE(l.front() == 1);
+
+    std::pmr::string s("a string long enough to leave the small buffer", &r);
+    s += s;
+    REQUIRE(s.size() == 92);
+}
+} // namespace
+
+TEST_CASE("Memory resource: arena", "[memory_resource][arena]")
+{
+    arena a(PAGE * 64);
+    arena_resource r(&a);
+    exercise(r);
+    REQUIRE(r.get_arena() == &a);
+
+    SECTION("Alignment is passed through")
+    {
+        void* p = r.allocate(10, 256);
+        REQUIRE(reinterpret_cast<uintptr_t>(p) % 256 == 0);
+    }
+
+    SECTION("Deallocating the most recent block hands its bytes back")
+    {
+        void* p = r.allocate(1000, 8);
+        const size_t used = a.get_used();
+        r.deallocate(p, 1000, 8);
+        REQUIRE(a.get_used() == used - 1000);
+        REQUIRE(r.allocate(1000, 8) == p);
+
+        // an older block stays used
+        void* newer = r.allocate(16, 8);
+        r.deallocate(p, 1000, 8);
+        REQUIRE(r.allocate(16, 8) != p);
+        (void)newer;
+    }
+
+    SECTION("A full arena throws")
+    {
+        REQUIRE_THROWS_AS(r.allocate(PAGE * 128), std::bad_alloc);
+    }
+}
+
+TEST_CASE("Memory resource: slab and dynamic_slab", "[memory_resource][slab]")
+{
+    SECTION("slab")
+    {
+        slab s(1);
+        slab_resource r(&s);
+        exercise(r);
+
+        void* p = r.allocate(8, 64);
+        REQUIRE(reinterpret_cast<uintptr_t>(p) % 64 == 0);
+        r.deallocate(p, 8, 64);
+        REQUIRE_THROWS_AS(r.allocate(PAGE * 4), std::bad_alloc);
+    }
+
+    SECTION("dynamic_slab")
+    {
+        dynamic_slab s(1);
+        dynamic_slab_resource r(&s);
+        exercise(r);
+
+        void* p = r.allocate(24, 32);
+        REQUIRE(reinterpret_cast<uintptr_t>(p) % 32 == 0);
+        r.deallocate(p, 24, 32);
+        REQUIRE(r.is_equal(r));
+
+        dynamic_slab_resource other(&s);
+        REQUIRE_FALSE(r.is_equal(other));
+    }
+}
+
+TEST_CASE("Memory resource: pool", "[memory_resource][pool]")
+{
+    // std::pmr::list<int> nodes are two pointers and an int
+    pool p(32, 256);
+    pool_resource r(&p);
+
+    std::pmr::list<int> l(&r);
+    for (int i = 0; i < 200; ++i)
+        l.push_back(i);
+    REQUIRE(p.get_free_space() == 56 * 32);
+    l.clear();
+    REQUIRE(p.get_free_space() == 256 * 32);
+
+    REQUIRE_THROWS_AS(r.allocate(64), std::bad_alloc);
+    REQUIRE_THROWS_AS(r.allocate(8, 64), std::bad_alloc);
+    void* block = r.allocate(8, 32);
+    REQUIRE(reinterpret_cast<uintptr_t>(block) % 32 == 0);
+    r.deallocate(block, 8, 32);
+}
+
+TEST_CASE("Memory resource: pool blocks larger than a page", "[memory_resource][pool]")
+{
+    // the pool starts page aligned, so a block of two pages is only page aligned
+    pool p(PAGE * 2, 16);
+    pool_resource r(&p);
+
+    REQUIRE_THROWS_AS(r.allocate(PAGE * 2, PAGE * 2), std::bad_alloc);
+
+    std::vector<void*> blocks;
+    for (int i = 0; i < 16; ++i)
+    {
+        void* block = r.allocate(PAGE * 2, PAGE);
+        REQUIRE(reinterpret_cast<uintptr_t>(block) % PAGE == 0);
+        blocks.push_back(block);
+    }
+    for (void* block : blocks)
+        r.deallocate(block, PAGE * 2, PAGE);
+}
@@ -0,0 +1,80 @@
+#include "page_map.h"
+#include <catch2/catch_test_macros.hpp>
+#include <cstdint>
+
+using namespace AL;
+
+namespace
+{
+const void* addr(uintptr_t a)
+{
+    return reinterpret_cast<const void*>(a);
+}
+} // namespace
+
+TEST_CASE("Page map: empty map finds nothing", "[page_map]")
+{
+    page_map map;
+    REQUIRE(map.find(addr(0x10000)) == nullptr);
+    REQUIRE(map.find(nullptr) == nullptr);
+}
+
+TEST_CASE("Page map: insert covers every overlapping page", "[page_map]")
+{
+    page_map map;
+    int owner = 0;
+
+    // starts mid page and ends mid page, so three pages are touched
+    REQUIRE(map.insert(addr(0x7f0000001800), addr(0x7f0000003800), &owner));
+
+    REQUIRE(map.find(addr(0x7f0000001000)) == &owner);
+    REQUIRE(map.find(addr(0x7f0000002abc)) == &owner);
+    REQUIRE(map.find(addr(0x7f0000003fff)) == &owner);
+    REQUIRE(map.find(addr(0x7f0000000fff)) == nullptr);
+    REQUIRE(map.find(addr(0x7f0000004000)) == nullptr);
+}
+
+TEST_CASE("Page map: ranges spanning leaves and owners side by side", "[page_map]")
+{
+    page_map map;
+    int a = 0;
+    int b = 0;
+
+    // one leaf covers 1 GiB, so this range crosses a leaf boundary
+    const uintptr_t boundary = uintptr_t{1} << (page_map::page_shift + page_map::leaf_bits);
+    REQUIRE(map.insert(addr(boundary - 0x2000), addr(boundary + 0x2000), &a));
+    REQUIRE(map.insert(addr(boundary + 0x2000), addr(boundary + 0x3000), &b));
+
+    REQUIRE(map.find(addr(boundary - 1)) == &a);
+    REQUIRE(map.find(addr(boundary)) == &a);
+    REQUIRE(map.find(addr(boundary + 0x1fff)) == &a);
+    REQUIRE(map.find(addr(boundary + 0x2000)) == &b);
+}
+
+TEST_CASE("Page map: erase clears only the given range", "[page_map]")
+{
+    page_map map;
+    int owner = 0;
+
+    REQUIRE(map.insert(addr(0x100000), addr(0x104000), &owner));
+    map.erase(addr(0x101000), addr(0x103000));
+
+    REQUIRE(map.find(addr(0x100000)) == &owner);
+    REQUIRE(map.find(addr(0x101000)) == nullptr);
+    REQUIRE(map.find(addr(0x102000)) == nullptr);
+    REQUIRE(map.find(addr(0x103000)) == &owner);
+}
+
+TEST_CASE("Page map: rejects addresses outside the 48 bit space", "[page_map]")
+{
+    page_map map;
+    int owner = 0;
+
+    const uintptr_t high = uintptr_t{1} << page_map::address_bits;
+    REQUIRE_FALSE(map.insert(addr(high), addr(high + 0x1000), &owner));
+    REQUIRE(map.find(addr(high)) == nullptr);
+
+    // empty ranges succeed without mapping anything
+    REQUIRE(map.insert(addr(0x1000), addr(0x1000), &owner));
+    REQUIRE(map.find(addr(0x1000)) == nullptr);
+}
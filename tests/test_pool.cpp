@@ -555,3 +555,34 @@ TEST_CASE("Pool: Alloc exhaustion then reset then reuse", "[pool][reset][edge]")
     REQUIRE(p.alloc() == nullptr);
 }
 
+TEST_CASE("Pool: Stats snapshot", "[pool][stats]")
+{
+    AL::pool p(64, 4);
+
+    void* a = p.alloc();
+    void* b = p.alloc();
+    p.free(a);
+
+    AL::pool_stats st = p.stats();
+    REQUIRE(st.block_size == 64);
+    REQUIRE(st.block_count == 4);
+    REQUIRE(st.free_blocks == 3);
+
+    if constexpr (AL::stats_enabled)
+    {
+        REQUIRE(st.allocs == 2);
+        REQUIRE(st.frees == 1);
+        REQUIRE(st.exhausted == 0);
+
+        void* c = p.alloc();
+        void* d = p.alloc();
+        void* e = p.alloc();
+        REQUIRE(p.alloc() == nullptr);
+        REQUIRE(p.stats().exhausted == 1);
+        p.free(c);
+        p.free(d);
+        p.free(e);
+    }
+
+    p.free(b);
+}
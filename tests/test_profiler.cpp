@@ -0,0 +1,101 @@
+#include "dynamic_slab.h"
+#include "profiler.h"
+#include "slab.h"
+#include <catch2/catch_test_macros.hpp>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace AL;
+
+TEST_CASE("Heap profiler: idle until a sample rate is set", "[profiler]")
+{
+    heap_profiler::clear();
+    REQUIRE(heap_profiler::get_sample_rate() == 0);
+
+    slab s;
+    void* p = s.alloc(64);
+    REQUIRE(p != nullptr);
+    REQUIRE(heap_profiler::get_live_samples() == 0);
+    s.free(p, 64);
+}
+
+TEST_CASE("Heap profiler: live samples follow alloc and free", "[profiler]")
+{
+    heap_profiler::clear();
+    heap_profiler::set_sample_rate(1); // every allocation crosses the threshold
+
+    slab s;
+    std::vector<void*> ptrs;
+    for (size_t i = 0; i < 50; ++i)
+    {
+        void* p = s.alloc(100); // 128B class
+        REQUIRE(p != nullptr);
+        ptrs.push_back(p);
+    }
+
+    for (size_t i = 0; i < 20; ++i)
+        s.free(ptrs[i], 100);
+
+    std::ostringstream pprof;
+    std::ostringstream collapsed;
+    heap_profiler::write_pprof(pprof);
+    heap_profiler::write_collapsed(collapsed);
+
+    if constexpr (profiling_enabled)
+    {
+        REQUIRE(heap_profiler::get_live_samples() == 30);
+        REQUIRE(pprof.str().rfind("heap profile: 30: 3840 [30: 3840] @ heap_v2/1\n", 0) == 0);
+        REQUIRE(pprof.str().find("MAPPED_LIBRARIES:") != std::string::npos);
+
+        // one line per distinct stack, each ending in a byte count
+        std::string line;
+        std::istringstream lines(collapsed.str());
+        size_t count = 0;
+        while (std::getline(lines, line))
+        {
+            REQUIRE(line.find(' ') != std::string::npos);
+            REQUIRE(std::stoull(line.substr(line.rfind(' ') + 1)) >= 128);
+            count++;
+        }
+        REQUIRE(count >= 1);
+    }
+    else
+    {
+        REQUIRE(heap_profiler::get_live_samples() == 0);
+        REQUIRE(pprof.str().empty());
+        REQUIRE(collapsed.str().empty());
+    }
+
+    for (size_t i = 20; i < ptrs.size(); ++i)
+        s.free(ptrs[i], 100);
+    REQUIRE(heap_profiler::get_live_samples() == 0);
+
+    heap_profiler::set_sample_rate(0);
+    heap_profiler::clear();
+}
+
+TEST_CASE("Heap profiler: dynamic_slab allocations are sampled", "[profiler][dynamic_slab]")
+{
+    heap_profiler::clear();
+    heap_profiler::set_sample_rate(1);
+
+    dynamic_slab ds(0.01);
+    std::vector<void*> ptrs;
+    for (size_t i = 0; i < 100; ++i)
+    {
+        void* p = ds.palloc(32);
+        REQUIRE(p != nullptr);
+        ptrs.push_back(p);
+    }
+
+    if constexpr (profiling_enabled)
+        REQUIRE(heap_profiler::get_live_samples() == 100);
+
+    for (void* p : ptrs)
+        ds.free(p, 32);
+    REQUIRE(heap_profiler::get_live_samples() == 0);
+
+    heap_profiler::set_sample_rate(0);
+    heap_profiler::clear();
+}
@@ -0,0 +1,160 @@
+#include "allocator.h"
+#include "request_heap.h"
+#include <catch2/catch_test_macros.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <list>
+#include <unistd.h>
+#include <vector>
+
+using namespace AL;
+
+static const size_t PAGE = getpagesize();
+
+TEST_CASE("Request heap: freed blocks are recycled within the request", "[request_heap]")
+{
+    request_heap h(PAGE * 16);
+
+    SECTION("A freed block serves the next alloc of its class")
+    {
+        void* a = h.alloc(100);
+        REQUIRE(a != nullptr);
+        const size_t used = h.get_used();
+
+        h.free(a, 100);
+        // 100 and 120 share the 128 byte class
+        REQUIRE(h.alloc(120) == a);
+        REQUIRE(h.get_used() == used);
+        if constexpr (stats_enabled)
+        {
+            REQUIRE(h.stats().recycled == 1);
+            REQUIRE(h.stats().frees == 1);
+        }
+    }
+
+    SECTION("Free lists are LIFO and per class")
+    {
+        void* small1 = h.alloc(8);
+        void* small2 = h.alloc(8);
+        void* big = h.alloc(2000);
+        h.free(small1, 8);
+        h.free(small2, 8);
+        h.free(big, 2000);
+
+        REQUIRE(h.alloc(4) == small2);
+        REQUIRE(h.alloc(8) == small1);
+        REQUIRE(h.alloc(1500) == big);
+    }
+
+    SECTION("Churn does not grow the arena")
+    {
+        for (size_t i = 0; i < 10000; ++i)
+        {
+            void* p = h.alloc(64);
+            REQUIRE(p != nullptr);
+            std::memset(p, 0x5a, 64);
+            h.free(p, 64);
+        }
+        REQUIRE(h.get_used() == 64);
+    }
+
+    SECTION("Blocks keep their alignment")
+    {
+        for (size_t size : {1, 8, 24, 100, 4096})
+        {
+            for (size_t alignment : {1, 8, 16})
+            {
+                // twice, so the second block follows one of the same class
+                REQUIRE(reinterpret_cast<uintptr_t>(h.alloc(size, alignment)) % alignment == 0);
+                REQUIRE(reinterpret_cast<uintptr_t>(h.alloc(size, alignment)) % alignment == 0);
+            }
+            REQUIRE(reinterpret_cast<uintptr_t>(h.alloc(size)) % request_heap::default_alignment == 0);
+        }
+        REQUIRE(reinterpret_cast<uintptr_t>(h.alloc(64, 64)) % 64 == 0);
+        REQUIRE(h.alloc(8, 3) == nullptr);
+        REQUIRE(h.alloc(0) == nullptr);
+    }
+
+    SECTION("A recycled block keeps its alignment")
+    {
+        void* a = h.alloc(8, 8);
+        void* b = h.alloc(8, 8);
+        REQUIRE(reinterpret_cast<uintptr_t>(a) % 8 == 0);
+        REQUIRE(reinterpret_cast<uintptr_t>(b) % 8 == 0);
+        h.free(b, 8, 8);
+
+        // an 8 aligned block is not handed to a 16 aligned request
+        for (size_t size : {1, 8})
+        {
+            void* p = h.alloc(size, 16);
+            REQUIRE(reinterpret_cast<uintptr_t>(p) % 16 == 0);
+            h.free(p, size, 16);
+            REQUIRE(h.alloc(size, 16) == p);
+            REQUIRE(reinterpret_cast<uintptr_t>(h.alloc(size)) % 16 == 0);
+        }
+        REQUIRE(h.alloc(8, 8) == b);
+    }
+
+    SECTION("Large blocks come from the arena and wait for reset")
+    {
+        void* big = h.alloc(PAGE * 2);
+        REQUIRE(big != nullptr);
+        h.free(big, PAGE * 2);
+        REQUIRE(h.alloc(PAGE * 2) != big);
+    }
+}
+
+TEST_CASE("Request heap: reset drops every block", "[request_heap][reset]")
+{
+    request_heap h(PAGE * 4);
+    std::vector<void*> blocks;
+    void* p;
+    while ((p = h.alloc(256)) != nullptr)
+        blocks.push_back(p);
+    REQUIRE(blocks.size() == PAGE * 4 / 256);
+    h.free(blocks[0], 256);
+
+    REQUIRE(h.reset() == 0);
+    REQUIRE(h.get_used() == 0);
+
+    // the free list is gone with the arena, so the first block is carved again, not recycled
+    REQUIRE(h.alloc(256) == blocks[0]);
+    REQUIRE(h.get_used() == 256);
+    if constexpr (stats_enabled)
+    {
+        REQUIRE(h.stats().recycled == 0);
+        REQUIRE(h.stats().resets == 1);
+    }
+}
+
+TEST_CASE("Request heap: allocator adaptor", "[request_heap][allocator]")
+{
+    request_heap h(PAGE * 64);
+
+    {
+        std::list<int, request_heap_allocator<int>> l{request_heap_allocator<int>(&h)};
+        for (int i = 0; i < 100; ++i)
+            l.push_back(i);
+        const size_t used = h.get_used();
+
+        // erased nodes are reused by the next inserts
+        for (int i = 0; i < 50; ++i)
+            l.pop_front();
+        for (int i = 0; i < 50; ++i)
+            l.push_back(i);
+        REQUIRE(h.get_used() == used);
+        REQUIRE(l.size() == 100);
+    }
+
+    {
+        std::vector<uint64_t, request_heap_allocator<uint64_t>> v{request_heap_allocator<uint64_t>(&h)};
+        for (uint64_t i = 0; i < 1000; ++i)
+            v.push_back(i);
+        for (uint64_t i = 0; i < 1000; ++i)
+            REQUIRE(v[i] == i);
+    }
+
+    REQUIRE(h.reset() == 0);
+    REQUIRE(h.get_used() == 0);
+}
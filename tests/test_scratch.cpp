@@ -0,0 +1,103 @@
+#include "scratch.h"
+#include <catch2/catch_test_macros.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <unistd.h>
+
+using namespace AL;
+
+static const size_t PAGE = getpagesize();
+
+TEST_CASE("Scratch: scopes rewind on exit", "[scratch]")
+{
+    {
+        scratch_scope outer;
+        auto* a = static_cast<unsigned char*>(outer.alloc(100));
+        REQUIRE(a != nullptr);
+        REQUIRE(reinterpret_cast<uintptr_t>(a) % alignof(std::max_align_t) == 0);
+        std::memset(a, 0x11, 100);
+        const size_t after_outer = scratch_scope::get_thread_used();
+        REQUIRE(after_outer >= 100);
+        REQUIRE(scratch_scope::get_thread_capacity() == scratch_scope::default_reserve);
+
+        {
+            scratch_scope inner;
+            void* b = inner.alloc(1000);
+            REQUIRE(b != nullptr);
+            std::memset(b, 0x22, 1000);
+            REQUIRE(scratch_scope::get_thread_used() > after_outer);
+        }
+        REQUIRE(scratch_scope::get_thread_used() == after_outer);
+
+        // the inner scope's memory is handed out again, the outer one's is intact
+        scratch_scope again;
+        auto* c = static_cast<unsigned char*>(again.calloc(1000));
+        REQUIRE(c != nullptr);
+        REQUIRE(c[999] == 0);
+        for (size_t i = 0; i < 100; ++i)
+            REQUIRE(a[i] == 0x11);
+    }
+    REQUIRE(scratch_scope::get_thread_used() == 0);
+}
+
+TEST_CASE("Scratch: alignment and bad requests", "[scratch]")
+{
+    scratch_scope s;
+    void* p1 = s.alloc(3, 1);
+    void* p2 = s.alloc(1, 1);
+    REQUIRE(static_cast<std::byte*>(p2) == static_cast<std::byte*>(p1) + 3);
+    REQUIRE(reinterpret_cast<uintptr_t>(s.alloc(10, PAGE)) % PAGE == 0);
+    REQUIRE(s.alloc(0) == nullptr);
+    REQUIRE(s.alloc(8, 3) == nullptr);
+}
+
+TEST_CASE("Scratch: the reserve bounds a thread's scopes", "[scratch][reserve]")
+{
+    std::thread t([] {
+        // a thread with its own reserve, mapped on first use
+        REQUIRE(scratch_scope::set_thread_reserve(PAGE * 2) == 0);
+        REQUIRE(scratch_scope::get_thread_capacity() == 0);
+        {
+            scratch_scope s;
+            REQUIRE(s.alloc(PAGE) != nullptr);
+            REQUIRE(scratch_scope::get_thread_capacity() == PAGE * 2);
+            REQUIRE(s.alloc(PAGE) != nullptr);
+            REQUIRE(s.alloc(1) == nullptr);
+
+            // not while the region is in use
+            REQUIRE(scratch_scope::set_thread_reserve(PAGE * 8) == -1);
+        }
+        REQUIRE(scratch_scope::set_thread_reserve(PAGE * 8) == 0);
+        REQUIRE(scratch_scope::get_thread_capacity() == 0);
+
+        scratch_scope s;
+        REQUIRE(s.alloc(PAGE * 8) != nullptr);
+    });
+    t.join();
+}
+
+TEST_CASE("Scratch: every thread has its own region", "[scratch][thread]")
+{
+    scratch_scope s;
+    auto* mine = static_cast<unsigned char*>(s.alloc(256));
+    std::memset(mine, 0xaa, 256);
+
+    void* theirs = nullptr;
+    size_t their_used = 0;
+    std::thread t([&] {
+        scratch_scope other;
+        theirs = other.alloc(256);
+        if (theirs != nullptr)
+            std::memset(theirs, 0xbb, 256);
+        their_used = scratch_scope::get_thread_used();
+    });
+    t.join();
+
+    REQUIRE(theirs != nullptr);
+    REQUIRE(theirs != mine);
+    REQUIRE(their_used == 256);
+    for (size_t i = 0; i < 256; ++i)
+        REQUIRE(mine[i] == 0xaa);
+}
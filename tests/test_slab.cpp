@@ -736,3 +736,54 @@ TEST_CASE("Slab: Calloc on TLC-cached sizes zeros memory", "[slab][tlc][calloc]"
         }
     }
 }
+
+TEST_CASE("Slab: Stats snapshot", "[slab][stats]")
+{
+    AL::slab s;
+
+    SECTION("Structural values match the getters")
+    {
+        AL::slab_stats st = s.stats();
+        REQUIRE(st.capacity == s.get_total_capacity());
+        REQUIRE(st.free_bytes == s.get_total_free());
+        REQUIRE(st.classes[3].pool.block_size == 64);
+        REQUIRE(st.classes[9].pool.block_size == 4096);
+    }
+
+    SECTION("Thread cache hits, refills and cached bytes are counted")
+    {
+        void* p = s.alloc(64); // miss, refills a batch
+        s.free(p, 64);
+        void* q = s.alloc(64); // hit
+        s.free(q, 64);
+
+        AL::slab_stats st = s.stats();
+        if constexpr (AL::stats_enabled)
+        {
+            REQUIRE(st.classes[3].tlc_refills == 1);
+            REQUIRE(st.classes[3].tlc_hits == 1);
+            REQUIRE(st.classes[3].cached_bytes > 0);
+            REQUIRE(st.thread_caches == 1);
+            // nothing is live, so every byte is either in a pool or in a thread cache
+            REQUIRE(st.free_bytes + st.cached_bytes == st.capacity);
+        }
+        else
+        {
+            REQUIRE(st.classes[3].tlc_hits == 0);
+            REQUIRE(st.cached_bytes == 0);
+        }
+    }
+
+    SECTION("Pool exhaustion is counted")
+    {
+        AL::slab tiny(0.001);
+        while (tiny.alloc(8) != nullptr)
+        {
+        }
+
+        AL::slab_stats st = tiny.stats();
+        if constexpr (AL::stats_enabled)
+            REQUIRE(st.classes[0].pool.exhausted > 0);
+        REQUIRE(st.classes[0].pool.free_blocks == 0);
+    }
+}
@@ -9,6 +9,7 @@
 #include <cstddef>
 #include <cstring>
 #include <memory>
+#include <optional>
 #include <thread>
 #include <unordered_set>
 #include <utility>
@@ -1920,3 +1921,338 @@ TEST_CASE("Slab thread safety: alloc-only burst then bulk free", "[slab][thread]
     for (auto& t : workers)
         t.join();
 }
+
+TEST_CASE("Slab thread safety: stats aggregate live and exited thread caches", "[slab][thread][stats]")
+{
+    const size_t threads = worker_count();
+    const size_t cycles = 1000;
+    AL::slab slab(2.0);
+
+    std::atomic<bool> start{false};
+    std::atomic<size_t> ready{0};
+    std::atomic<bool> release{false};
+    std::vector<std::thread> workers;
+    workers.reserve(threads);
+
+    for (size_t tid = 0; tid < threads; ++tid)
+    {
+        workers.emplace_back([&] {
+            wait_for_start(start);
+            for (size_t i = 0; i < cycles; ++i)
+            {
+                void* ptr = slab.alloc(32);
+                REQUIRE(ptr != nullptr);
+                slab.free(ptr, 32);
+            }
+            ready.fetch_add(1, std::memory_order_acq_rel);
+            wait_for_start(release);
+        });
+    }
+
+    start.store(true, std::memory_order_release);
+    while (ready.load(std::memory_order_acquire) != threads)
+        std::this_thread::yield();
+
+    // every worker still holds its cache entry here
+    AL::slab_stats live = slab.stats();
+    size_t visited = 0;
+    slab.for_each_thread_cache([&](const AL::thread_cache_stats& t) {
+        visited++;
+        REQUIRE(t.total_bytes == t.cached_bytes[2]);
+    });
+
+    release.store(true, std::memory_order_release);
+    for (auto& t : workers)
+        t.join();
+
+    // exited threads fold their counters into the slab
+    AL::slab_stats done = slab.stats();
+
+    if constexpr (AL::stats_enabled)
+    {
+        REQUIRE(live.thread_caches == threads);
+        REQUIRE(visited == threads);
+        REQUIRE(live.classes[2].tlc_hits + live.classes[2].tlc_refills >= threads * cycles);
+        REQUIRE(live.classes[2].cached_bytes > 0);
+        REQUIRE(done.thread_caches == 0);
+        REQUIRE(done.classes[2].tlc_hits == live.classes[2].tlc_hits);
+        REQUIRE(done.classes[2].tlc_refills == live.classes[2].tlc_refills);
+    }
+    else
+    {
+        REQUIRE(visited == 0);
+        REQUIRE(done.classes[2].tlc_hits == 0);
+    }
+}
+
+TEST_CASE("Slab thread safety: exiting threads return their cached blocks", "[slab][thread][tlc]")
+{
+    AL::slab slab(1.0);
+    std::vector<std::thread> workers;
+    for (size_t tid = 0; tid < 4; ++tid)
+    {
+        workers.emplace_back([&] {
+            std::vector<void*> ptrs;
+            for (size_t i = 0; i < 40; ++i)
+                ptrs.push_back(slab.alloc(64));
+            for (void* p : ptrs)
+                slab.free(p, 64);
+        });
+    }
+    for (auto& t : workers)
+        t.join();
+
+    REQUIRE(slab.is_unused());
+}
+
+TEST_CASE("Slab thread safety: destroying a slab detaches other threads' caches", "[slab][thread][tlc]")
+{
+    std::optional<AL::slab> slab;
+    slab.emplace(1.0);
+
+    std::atomic<bool> cached{false};
+    std::atomic<bool> replaced{false};
+    std::atomic<bool> done{false};
+    std::atomic<bool> checked{false};
+    std::thread worker([&] {
+        // leaves blocks of the first slab in this thread's cache
+        void* p = slab->alloc(32);
+        slab->free(p, 32);
+        cached.store(true, std::memory_order_release);
+
+        wait_for_start(replaced);
+        p = slab->alloc(32);
+        REQUIRE(slab->owns(p));
+        slab->free(p, 32);
+        done.store(true, std::memory_order_release);
+
+        // exiting returns the cached blocks, so stay until the pool has been checked
+        wait_for_start(checked);
+    });
+
+    wait_for_start(cached);
+    // same address, so a stale entry would still match it
+    slab.reset();
+    slab.emplace(1.0);
+    const size_t fresh = slab->get_pool_free_space(2);
+    replaced.store(true, std::memory_order_release);
+
+    wait_for_start(done);
+    // the worker had to refill from the new slab's pool instead of handing out old blocks
+    REQUIRE(slab->get_pool_free_space(2) < fresh);
+    checked.store(true, std::memory_order_release);
+    worker.join();
+    REQUIRE(slab->is_unused());
+}
+
+TEST_CASE("Slab thread safety: slabs destroyed while other threads evict them", "[slab][thread][tlc]")
+{
+    const size_t threads = worker_count();
+    constexpr size_t rounds = 200;
+
+    for (size_t round = 0; round < 20; ++round)
+    {
+        std::optional<AL::slab> shared;
+        shared.emplace(1.0);
+        std::atomic<size_t> ready{0};
+        std::vector<std::thread> workers;
+
+        for (size_t tid = 0; tid < threads; ++tid)
+        {
+            workers.emplace_back([&] {
+                void* p = shared->alloc(64);
+                shared->free(p, 64);
+                ready.fetch_add(1, std::memory_order_acq_rel);
+
+                // per-request slabs, enough of them to push the shared slab's entry out
+                for (size_t r = 0; r < rounds; ++r)
+                {
+                    AL::slab local(0);
+                    void* q = local.alloc(64);
+                    REQUIRE(q != nullptr);
+                    local.free(q, 64);
+                }
+            });
+        }
+
+        while (ready.load(std::memory_order_acquire) != threads)
+            std::this_thread::yield();
+        // races with the workers evicting and flushing their entries for it
+        shared.reset();
+
+        for (auto& t : workers)
+            t.join();
+    }
+}
+
+TEST_CASE("Arena thread safety: thread chunks hand out unique memory", "[arena][thread][chunks]")
+{
+    const size_t threads = worker_count();
+    const size_t alloc_size = 48;
+    const size_t allocs_per_thread = 2000;
+    const size_t chunk = 4096;
+    // every thread may leave the tail of its last chunk unused
+    AL::arena arena(threads * (allocs_per_thread * alloc_size + 2 * chunk));
+    arena.set_thread_chunk_size(chunk);
+
+    std::atomic<bool> start{false};
+    std::atomic<size_t> null_allocations{0};
+    std::vector<std::vector<void*>> allocated(threads);
+    std::vector<std::thread> workers;
+    workers.reserve(threads);
+
+    for (size_t tid = 0; tid < threads; ++tid)
+    {
+        workers.emplace_back([&, tid] {
+            auto& local = allocated[tid];
+            local.reserve(allocs_per_thread);
+            wait_for_start(start);
+
+            for (size_t i = 0; i < allocs_per_thread; ++i)
+            {
+                void* ptr = arena.alloc(alloc_size);
+                if (ptr == nullptr)
+                {
+                    null_allocations.fetch_add(1, std::memory_order_relaxed);
+                    continue;
+                }
+                std::memset(ptr, static_cast<int>(tid & 0xFF), alloc_size);
+                local.push_back(ptr);
+            }
+        });
+    }
+
+    start.store(true, std::memory_order_release);
+    for (auto& t : workers)
+        t.join();
+
+    REQUIRE(null_allocations.load() == 0);
+
+    std::unordered_set<void*> unique_ptrs;
+    for (size_t tid = 0; tid < threads; ++tid)
+    {
+        for (void* ptr : allocated[tid])
+        {
+            REQUIRE(unique_ptrs.insert(ptr).second);
+            const auto* bytes = static_cast<const unsigned char*>(ptr);
+            for (size_t j = 0; j < alloc_size; ++j)
+                REQUIRE(bytes[j] == (tid & 0xFF));
+        }
+    }
+    REQUIRE(arena.get_used() <= arena.get_capacity());
+
+    // after a synchronized reset every thread starts a fresh chunk
+    arena.reset();
+    void* fresh = nullptr;
+    std::thread again([&] { fresh = arena.alloc(alloc_size); });
+    again.join();
+    REQUIRE(fresh != nullptr);
+    REQUIRE(arena.get_used() == chunk);
+}
+
+TEST_CASE("Arena thread safety: both ends never overlap", "[arena][thread][top]")
+{
+    // half the threads allocate from the bottom and half from the top until the two ends meet
+    const size_t threads = std::max<size_t>(worker_count(), 2);
+    const size_t alloc_size = 40;
+    AL::arena arena(64 * 1024);
+
+    std::atomic<bool> start{false};
+    std::vector<std::vector<void*>> allocated(threads);
+    std::vector<std::thread> workers;
+    workers.reserve(threads);
+
+    for (size_t tid = 0; tid < threads; ++tid)
+    {
+        workers.emplace_back([&, tid] {
+            auto& local = allocated[tid];
+            wait_for_start(start);
+
+            while (true)
+            {
+                void* ptr = tid % 2 == 0 ? arena.alloc(alloc_size, 8) : arena.alloc_top(alloc_size, 8);
+                if (ptr == nullptr)
+                    break;
+                std::memset(ptr, static_cast<int>(tid & 0xFF), alloc_size);
+                local.push_back(ptr);
+            }
+        });
+    }
+
+    start.store(true, std::memory_order_release);
+    for (auto& t : workers)
+        t.join();
+
+    std::unordered_set<void*> unique_ptrs;
+    size_t total = 0;
+    for (size_t tid = 0; tid < threads; ++tid)
+    {
+        for (void* ptr : allocated[tid])
+        {
+            REQUIRE(unique_ptrs.insert(ptr).second);
+            const auto* bytes = static_cast<const unsigned char*>(ptr);
+            for (size_t j = 0; j < alloc_size; ++j)
+                REQUIRE(bytes[j] == (tid & 0xFF));
+            ++total;
+        }
+    }
+    REQUIRE(arena.get_used() + arena.get_used_top() <= arena.get_capacity());
+    REQUIRE(total * alloc_size <= arena.get_capacity());
+    // the ends only stop once less than two allocations are left between them
+    REQUIRE(arena.get_capacity() - (arena.get_used() + arena.get_used_top()) < 2 * alloc_size);
+}
+
+TEST_CASE("Arena thread safety: in-place extension never overlaps other allocations", "[arena][thread][extend]")
+{
+    const size_t threads = std::max<size_t>(worker_count(), 2);
+    const size_t rounds = 2000;
+    AL::arena arena(threads * rounds * 256);
+
+    struct block
+    {
+        unsigned char* ptr;
+        size_t length;
+    };
+
+    std::atomic<bool> start{false};
+    std::vector<std::vector<block>> allocated(threads);
+    std::vector<std::thread> workers;
+    workers.reserve(threads);
+
+    for (size_t tid = 0; tid < threads; ++tid)
+    {
+        workers.emplace_back([&, tid] {
+            auto& local = allocated[tid];
+            wait_for_start(start);
+
+            for (size_t i = 0; i < rounds; ++i)
+            {
+                auto* p = static_cast<unsigned char*>(arena.alloc(32, 8));
+                if (p == nullptr)
+                    break;
+                size_t length = 32;
+                // grows only while no other thread allocated behind it
+                while (length < 256 && arena.try_extend(p, length, length + 32))
+                    length += 32;
+                std::memset(p, static_cast<int>(tid & 0xFF), length);
+                local.push_back({p, length});
+            }
+        });
+    }
+
+    start.store(true, std::memory_order_release);
+    for (auto& t : workers)
+        t.join();
+
+    size_t total = 0;
+    for (size_t tid = 0; tid < threads; ++tid)
+    {
+        for (const block& b : allocated[tid])
+        {
+            for (size_t j = 0; j < b.length; ++j)
+                REQUIRE(b.ptr[j] == (tid & 0xFF));
+            total += b.length;
+        }
+    }
+    REQUIRE(total <= arena.get_used());
+}
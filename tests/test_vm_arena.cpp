@@ -0,0 +1,148 @@
+#include "vm_arena.h"
+#include <atomic>
+#include <catch2/catch_test_macros.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using namespace AL;
+
+static const size_t PAGE = getpagesize();
+
+TEST_CASE("VM arena: reserve without committing", "[vm_arena]")
+{
+    SECTION("The default reservation is 64 GiB and nothing is committed")
+    {
+        vm_arena a;
+        REQUIRE(a.get_reserved() == vm_arena::default_reserve);
+        REQUIRE(a.get_committed() == 0);
+        REQUIRE(a.get_used() == 0);
+    }
+
+    SECTION("Sizes round up to pages")
+    {
+        vm_arena a(PAGE * 10 + 1, PAGE + 1);
+        REQUIRE(a.get_reserved() == PAGE * 11);
+        REQUIRE(a.alloc(1) != nullptr);
+        REQUIRE(a.get_committed() == PAGE * 2);
+    }
+}
+
+TEST_CASE("VM arena: commits in steps as the offset advances", "[vm_arena]")
+{
+    const size_t step = PAGE * 16;
+    vm_arena a(size_t(1) << 30, step);
+
+    void* first = a.alloc(64);
+    REQUIRE(first != nullptr);
+    REQUIRE(a.get_committed() == step);
+    std::memset(first, 0xaa, 64);
+
+    SECTION("Allocations inside the committed range take no new step")
+    {
+        for (size_t i = 0; i < 100; ++i)
+            REQUIRE(a.alloc(64) != nullptr);
+        REQUIRE(a.get_committed() == step);
+        if constexpr (stats_enabled)
+            REQUIRE(a.stats().commits == 1);
+    }
+
+    SECTION("Crossing the committed range commits whole steps and keeps addresses stable")
+    {
+        auto* big = static_cast<unsigned char*>(a.alloc(step * 3));
+        REQUIRE(big != nullptr);
+        std::memset(big, 0xbb, step * 3);
+        REQUIRE(a.get_committed() == step * 4);
+
+        // contiguous with what came before, nothing moved
+        REQUIRE(big > static_cast<unsigned char*>(first));
+        REQUIRE(static_cast<unsigned char*>(first)[0] == 0xaa);
+    }
+
+    SECTION("Requests past the reservation fail")
+    {
+        REQUIRE(a.alloc(size_t(2) << 30) == nullptr);
+        REQUIRE(a.alloc(64) != nullptr);
+        if constexpr (stats_enabled)
+            REQUIRE(a.stats().failed_allocs == 1);
+    }
+
+    SECTION("Alignment")
+    {
+        REQUIRE(reinterpret_cast<uintptr_t>(a.alloc(10, PAGE)) % PAGE == 0);
+        void* p1 = a.alloc(3, 1);
+        void* p2 = a.alloc(1, 1);
+        REQUIRE(static_cast<std::byte*>(p2) == static_cast<std::byte*>(p1) + 3);
+        REQUIRE(a.alloc(8, 12) == nullptr);
+    }
+}
+
+TEST_CASE("VM arena: reset decommits above the retained size", "[vm_arena][reset]")
+{
+    const size_t step = PAGE * 4;
+    vm_arena a(size_t(1) << 30, step);
+    REQUIRE(a.alloc(step * 10) != nullptr);
+    REQUIRE(a.get_committed() == step * 10);
+
+    SECTION("By default everything stays committed")
+    {
+        REQUIRE(a.reset() == 0);
+        REQUIRE(a.get_used() == 0);
+        REQUIRE(a.get_committed() == step * 10);
+    }
+
+    SECTION("Retained size caps what stays committed, and the rest commits again on demand")
+    {
+        a.set_retained_bytes(step * 2);
+        REQUIRE(a.reset() == 0);
+        REQUIRE(a.get_committed() == step * 2);
+
+        auto* p = static_cast<unsigned char*>(a.alloc(step * 5));
+        REQUIRE(p != nullptr);
+        std::memset(p, 1, step * 5);
+        REQUIRE(a.get_committed() == step * 5);
+        if constexpr (stats_enabled)
+            REQUIRE(a.stats().resets == 1);
+    }
+}
+
+TEST_CASE("VM arena: concurrent allocation across commit steps", "[vm_arena][thread]")
+{
+    vm_arena a(size_t(1) << 30, PAGE);
+
+    constexpr size_t threads = 8;
+    constexpr size_t per_thread = 2000;
+    std::vector<std::vector<uint64_t*>> ptrs(threads);
+    std::vector<std::thread> workers;
+    std::atomic<size_t> failed{0};
+
+    for (size_t t = 0; t < threads; ++t)
+    {
+        workers.emplace_back([&, t] {
+            for (size_t i = 0; i < per_thread; ++i)
+            {
+                auto* p = static_cast<uint64_t*>(a.alloc(sizeof(uint64_t) * 8));
+                if (!p)
+                {
+                    failed.fetch_add(1);
+                    continue;
+                }
+                for (size_t j = 0; j < 8; ++j)
+                    p[j] = (t << 32) | i;
+                ptrs[t].push_back(p);
+            }
+        });
+    }
+    for (auto& w : workers)
+        w.join();
+
+    REQUIRE(failed.load() == 0);
+    REQUIRE(a.get_committed() >= a.get_used());
+    for (size_t t = 0; t < threads; ++t)
+        for (size_t i = 0; i < ptrs[t].size(); ++i)
+            for (size_t j = 0; j < 8; ++j)
+                REQUIRE(ptrs[t][i][j] == ((t << 32) | i));
+}